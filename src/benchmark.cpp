@@ -0,0 +1,311 @@
+// Benchmark of all processing methods over CRC widths, message sizes, data
+// alignment and cache state. Every configuration is warmed up and sampled
+// repeatedly, median and 99th percentile of the samples are reported.
+//
+// Usage: benchmark [--min-size=BYTES] [--max-size=BYTES] [--repetitions=N]
+//                  [--filter=TEXT] [--crossover] [--write-profile=PATH]
+// Sizes are swept in powers of 4. Only configurations whose name contains
+// TEXT are run, e.g. --filter=CRC32C/HW_CLMUL or --filter=/cold.
+// --crossover sweeps sizes in powers of 2 instead, prints the fastest method
+// for every size, the sizes where it changes, and methods selected for the
+// size classes by the calibrated CrcDispatcher.
+// --write-profile calibrates the dispatchers of all benchmarked CRCs, saves
+// the calibration profile to PATH and exits. Processes started with
+// HASHLIB_CRC_PROFILE=PATH then use it without calibration.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "crc.h"
+
+namespace {
+
+struct Configuration {
+  size_t min_size = 16;
+  size_t max_size = 64 * 1024 * 1024;
+  size_t repetitions = 31;
+  std::string filter;
+  bool crossover = false;
+  std::string profile;
+};
+
+// Cache larger than any last level cache, streamed over to evict the data.
+constexpr size_t kEvictionSize = 64 * 1024 * 1024;
+// Hot samples repeat short messages up to this many bytes, so the clock
+// resolution does not dominate.
+constexpr size_t kHotSampleBytes = 256 * 1024;
+// Time spent sampling single configuration, unless repetitions end first.
+constexpr double kConfigurationBudget = 0.25;
+constexpr size_t kMinSamples = 5;
+
+struct Sample {
+  double seconds;
+  double cycles;
+};
+
+// Statistics of all samples of single configuration, per byte.
+struct Result {
+  double median;
+  double p99;
+  double cycles;
+};
+
+class Timer {
+ public:
+  Timer()
+      : start_(std::chrono::steady_clock::now()),
+        cycles_(hash::hw::ReadCycles()) {}
+  Sample elapsed() const {
+    const uint64_t cycles = hash::hw::ReadCycles();
+    const std::chrono::duration<double> seconds =
+        std::chrono::steady_clock::now() - start_;
+    return {seconds.count(), static_cast<double>(cycles - cycles_)};
+  }
+
+ private:
+  std::chrono::steady_clock::time_point start_;
+  uint64_t cycles_;
+};
+
+void Evict(std::vector<uint8_t>& eviction) {
+  static uint8_t value = 0;
+  ++value;
+  for (size_t i = 0; i < eviction.size(); i += 64) {
+    eviction[i] = value;
+  }
+}
+
+double Percentile(std::vector<double> values, double percentile) {
+  std::sort(values.begin(), values.end());
+  const auto index = static_cast<size_t>(percentile * (values.size() - 1));
+  return values[index];
+}
+
+template <typename T>
+class Benchmark {
+ public:
+  Benchmark(const char* name, const hash::OptionsCrc& options,
+            const Configuration& configuration)
+      : name_(name), options_(options), configuration_(configuration) {}
+
+  // Xor of all calculated CRC values.
+  T checksum() const { return checksum_; }
+
+  void Run(const uint8_t* data, std::vector<uint8_t>& eviction) {
+    for (int method = hash::BYTE_BY_BYTE; method <= hash::CHUNKS_AUTO;
+         ++method) {
+      const auto chunks = static_cast<hash::CrcChunks>(method);
+      for (size_t size = configuration_.min_size;
+           size <= configuration_.max_size; size *= 4) {
+        for (const size_t alignment : {0, 1}) {
+          for (const bool cold : {false, true}) {
+            char label[128];
+            snprintf(label, sizeof(label), "%s/%s/%zu/align%zu/%s", name_,
+                     hash::CrcChunksName(chunks), size, alignment,
+                     (cold) ? "cold" : "hot");
+            if (!Matches(label)) {
+              continue;
+            }
+            const Result result =
+                Measure(chunks, data + alignment, size, cold, eviction);
+            printf("%-50s %12.4f %12.4f %10.3f %10.3f\n", label,
+                   result.median, result.p99, result.cycles,
+                   1.0 / result.median);
+          }
+        }
+      }
+    }
+  }
+
+  // Fastest method for every size of the hot aligned data.
+  void Crossover(const uint8_t* data, std::vector<uint8_t>& eviction) {
+    if (!Matches(name_)) {
+      return;
+    }
+    const char* previous = nullptr;
+    for (size_t size = configuration_.min_size;
+         size <= configuration_.max_size; size *= 2) {
+      const char* best = nullptr;
+      double best_time = 0;
+      for (int method = hash::BYTE_BY_BYTE; method < hash::CHUNKS_AUTO;
+           ++method) {
+        const auto chunks = static_cast<hash::CrcChunks>(method);
+        const double time = Measure(chunks, data, size, false, eviction).median;
+        if (best == nullptr || time < best_time) {
+          best = hash::CrcChunksName(chunks);
+          best_time = time;
+        }
+      }
+      printf("%s/best/%-12zu %-14s %10.4f ns/B", name_, size, best, best_time);
+      if (previous != nullptr && previous != best) {
+        printf("  <- crossover from %s", previous);
+      }
+      printf("\n");
+      previous = best;
+    }
+    hash::Crc<T> crc(options_);
+    crc.Optimize();
+    size_t lower = 0;
+    for (const size_t limit : hash::kSizeClassLimits) {
+      printf("%s/dispatch/%zu-%zu %s\n", name_, lower, limit,
+             hash::CrcChunksName(
+                 hash::CrcDispatcher<T>::Get(options_.reverse_data, limit)));
+      lower = limit + 1;
+    }
+    printf("%s/dispatch/%zu- %s\n", name_, lower,
+           hash::CrcChunksName(
+               hash::CrcDispatcher<T>::Get(options_.reverse_data)));
+  }
+
+ private:
+  Result Measure(hash::CrcChunks chunks, const uint8_t* data, size_t size,
+                 bool cold, std::vector<uint8_t>& eviction) {
+    hash::Crc<T> crc(options_);
+    // Allocate the table before timing and warm up the caches.
+    crc.Consume(data, size, chunks);
+    const size_t iterations =
+        (cold) ? 1 : std::max<size_t>(1, kHotSampleBytes / size);
+    std::vector<double> seconds;
+    std::vector<double> cycles;
+    double total = 0;
+    while (seconds.size() < configuration_.repetitions &&
+           (seconds.size() < kMinSamples || total < kConfigurationBudget)) {
+      if (cold) {
+        Evict(eviction);
+      }
+      const Timer timer;
+      for (size_t i = 0; i < iterations; ++i) {
+        crc.Consume(data, size, chunks);
+      }
+      const Sample sample = timer.elapsed();
+      const double bytes = static_cast<double>(size) * iterations;
+      seconds.push_back(sample.seconds * 1e9 / bytes);
+      cycles.push_back(sample.cycles / bytes);
+      total += sample.seconds;
+    }
+    // Keep the result alive, so the calculation is not optimized away.
+    checksum_ ^= crc.crc();
+
+    Result result;
+    result.median = Percentile(seconds, 0.5);
+    result.p99 = Percentile(seconds, 0.99);
+    result.cycles = Percentile(cycles, 0.5);
+    return result;
+  }
+
+  bool Matches(const char* label) const {
+    return configuration_.filter.empty() ||
+           std::strstr(label, configuration_.filter.c_str()) != nullptr;
+  }
+
+  const char* name_;
+  hash::OptionsCrc options_;
+  const Configuration& configuration_;
+  T checksum_ = 0;
+};
+
+bool ParseSize(const char* argument, const char* flag, size_t* value) {
+  const size_t length = std::strlen(flag);
+  if (std::strncmp(argument, flag, length) != 0) {
+    return false;
+  }
+  *value = std::strtoull(argument + length, nullptr, 10);
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Configuration configuration;
+  for (int i = 1; i < argc; ++i) {
+    const char* argument = argv[i];
+    if (ParseSize(argument, "--min-size=", &configuration.min_size) ||
+        ParseSize(argument, "--max-size=", &configuration.max_size) ||
+        ParseSize(argument, "--repetitions=", &configuration.repetitions)) {
+      continue;
+    }
+    if (std::strncmp(argument, "--filter=", 9) == 0) {
+      configuration.filter = argument + 9;
+      continue;
+    }
+    if (std::strcmp(argument, "--crossover") == 0) {
+      configuration.crossover = true;
+      continue;
+    }
+    if (std::strncmp(argument, "--write-profile=", 16) == 0) {
+      configuration.profile = argument + 16;
+      continue;
+    }
+    fprintf(stderr,
+            "Usage: %s [--min-size=BYTES] [--max-size=BYTES] "
+            "[--repetitions=N] [--filter=TEXT] [--crossover] "
+            "[--write-profile=PATH]\n",
+            argv[0]);
+    return 1;
+  }
+  if (!configuration.profile.empty()) {
+    // One CRC per type and data ordering, calibration covers all CRCs sharing
+    // them.
+    hash::Crc<uint8_t>(hash::OptionsCrc::Crc8()).Optimize();
+    hash::Crc<uint8_t>(hash::OptionsCrc::Crc8_MAXIM()).Optimize();
+    hash::Crc<uint16_t>(hash::OptionsCrc::Crc16_CCITT()).Optimize();
+    hash::Crc<uint16_t>(hash::OptionsCrc::Crc16()).Optimize();
+    hash::Crc<uint32_t>(hash::OptionsCrc::Crc24_OPENPGP()).Optimize();
+    hash::Crc<uint32_t>(hash::OptionsCrc::Crc32()).Optimize();
+    hash::Crc<uint64_t>(hash::OptionsCrc::Crc40_GSM()).Optimize();
+    hash::Crc<uint64_t>(hash::OptionsCrc::Crc64()).Optimize();
+    if (!hash::SaveCrcProfileFile(configuration.profile)) {
+      fprintf(stderr, "Can not write %s\n", configuration.profile.c_str());
+      return 1;
+    }
+    printf("%s", hash::SaveCrcProfile().c_str());
+    return 0;
+  }
+  configuration.min_size = std::max<size_t>(configuration.min_size, 1);
+  configuration.repetitions = std::max(configuration.repetitions, kMinSamples);
+
+  // Data is 64 byte aligned, with an extra byte for the misaligned runs.
+  std::vector<uint8_t> storage(configuration.max_size + 64 + 1);
+  for (size_t i = 0; i < storage.size(); ++i) {
+    storage[i] = static_cast<uint8_t>(i * 2654435761u >> 13);
+  }
+  const auto address = reinterpret_cast<uintptr_t>(storage.data());
+  const uint8_t* data = storage.data() + ((64 - address % 64) % 64);
+  std::vector<uint8_t> eviction(kEvictionSize);
+
+  const auto run = [&](auto& benchmark) {
+    if (configuration.crossover) {
+      benchmark.Crossover(data, eviction);
+    } else {
+      benchmark.Run(data, eviction);
+    }
+  };
+  if (!configuration.crossover) {
+    printf("%-50s %12s %12s %10s %10s\n", "crc/method/size/alignment/cache",
+           "median ns/B", "p99 ns/B", "cycles/B", "GB/s");
+  }
+  Benchmark<uint16_t> crc16("CRC16", hash::OptionsCrc::Crc16(), configuration);
+  run(crc16);
+  Benchmark<uint32_t> crc24("CRC24", hash::OptionsCrc::Crc24_OPENPGP(),
+                            configuration);
+  run(crc24);
+  Benchmark<uint32_t> crc32("CRC32", hash::OptionsCrc::Crc32(), configuration);
+  run(crc32);
+  Benchmark<uint32_t> crc32c("CRC32C", hash::OptionsCrc::Crc32C(),
+                             configuration);
+  run(crc32c);
+  Benchmark<uint64_t> crc64("CRC64", hash::OptionsCrc::Crc64(), configuration);
+  run(crc64);
+
+  // Print combined result, so none of the measured work can be discarded.
+  fprintf(stderr, "checksum %llX\n",
+          static_cast<unsigned long long>(crc16.checksum() ^ crc24.checksum() ^
+                                          crc32.checksum() ^ crc32c.checksum() ^
+                                          crc64.checksum()));
+  return 0;
+}
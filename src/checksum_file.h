@@ -0,0 +1,183 @@
+#ifndef CHECKSUM_FILE_H_
+#define CHECKSUM_FILE_H_
+
+#include <algorithm>  // std::min
+#include <cstdint>    // uint8_t
+#include <fstream>    // std::basic_ifstream
+#include <future>     // std::async / std::future
+#include <optional>   // std::optional
+#include <string>     // std::string
+#include <vector>     // std::vector
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HASHLIB_POSIX_FILE 1
+#include <fcntl.h>     // open / posix_fadvise
+#include <sys/mman.h>  // mmap / madvise
+#include <sys/stat.h>  // fstat
+#include <unistd.h>    // read / close
+
+#include <cerrno>  // errno
+#endif
+
+#include "crc.h"
+
+namespace hash {
+
+// Size of the block read ahead while the previous one is consumed.
+constexpr size_t kFileBlockSize = 4 * 1024 * 1024;
+
+// Consume whole file into 'crc', which is Crc or MultiCrc. Non-empty regular
+// files are memory mapped and read ahead by the kernel, other files are read
+// by a background thread into one buffer while the other one is consumed until
+// the end of file. Returns false if the file could not be read, in which case
+// 'crc' may contain part of the file.
+template <typename Checksum>
+bool ConsumeFile(const std::string& path, Checksum& crc);
+
+// Calculate CRC of the whole file. Returns std::nullopt if the file could
+// not be read.
+template <typename T = uint32_t>
+std::optional<T> ChecksumFile(const std::string& path,
+                              const OptionsCrc& options = OptionsCrc::Crc32());
+
+namespace detail {
+
+#if defined(HASHLIB_POSIX_FILE)
+
+// Closes file descriptor when leaving the scope.
+class FileDescriptor {
+ public:
+  explicit FileDescriptor(int fd) noexcept : fd_(fd) {}
+  ~FileDescriptor() {
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+  FileDescriptor(const FileDescriptor&) = delete;
+  FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+  int get() const noexcept { return fd_; }
+
+ private:
+  int fd_;
+};
+
+template <typename Checksum>
+bool ConsumeMapped(int fd, size_t size, Checksum& crc) {
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+  madvise(mapping, size, MADV_SEQUENTIAL);
+  const auto* data = static_cast<const uint8_t*>(mapping);
+  for (size_t offset = 0; offset < size; offset += kFileBlockSize) {
+    const size_t block = std::min(kFileBlockSize, size - offset);
+    // Request the next block, so page faults do not stall the consumption.
+    const size_t next = offset + block;
+    if (next < size) {
+      madvise(const_cast<uint8_t*>(data) + next,
+              std::min(kFileBlockSize, size - next), MADV_WILLNEED);
+    }
+    crc.Consume(data + offset, block);
+  }
+  munmap(mapping, size);
+  return true;
+}
+
+// Read up to 'size' bytes, retrying interrupted and partial reads. Returns
+// number of read bytes (less than 'size' at the end of file), -1 on error.
+inline ssize_t ReadBlock(int fd, uint8_t* buffer, size_t size) {
+  size_t total = 0;
+  while (total < size) {
+    const ssize_t count = read(fd, buffer + total, size - total);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return -1;
+    }
+    if (count == 0) {
+      break;
+    }
+    total += static_cast<size_t>(count);
+  }
+  return static_cast<ssize_t>(total);
+}
+
+template <typename Checksum>
+bool ConsumeBuffered(int fd, Checksum& crc) {
+#if defined(POSIX_FADV_SEQUENTIAL)
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+  std::vector<uint8_t> buffers[2] = {std::vector<uint8_t>(kFileBlockSize),
+                                     std::vector<uint8_t>(kFileBlockSize)};
+  const auto read_ahead = [fd](uint8_t* buffer) {
+    return std::async(std::launch::async, ReadBlock, fd, buffer,
+                      kFileBlockSize);
+  };
+  std::future<ssize_t> pending = read_ahead(buffers[0].data());
+  for (size_t current = 0;; current ^= 1) {
+    const ssize_t count = pending.get();
+    if (count < 0) {
+      return false;
+    }
+    if (count == 0) {
+      return true;
+    }
+    pending = read_ahead(buffers[current ^ 1].data());
+    crc.Consume(buffers[current].data(), static_cast<size_t>(count));
+  }
+}
+
+#endif
+
+}  // namespace detail
+
+template <typename Checksum>
+bool ConsumeFile(const std::string& path, Checksum& crc) {
+#if defined(HASHLIB_POSIX_FILE)
+  const detail::FileDescriptor fd(open(path.c_str(), O_RDONLY));
+  if (fd.get() < 0) {
+    return false;
+  }
+  struct stat status;
+  if (fstat(fd.get(), &status) != 0) {
+    return false;
+  }
+  // Files of /proc or /sys report size 0, but have content, read them until
+  // the end as well.
+  if (S_ISREG(status.st_mode) && status.st_size > 0 &&
+      detail::ConsumeMapped(fd.get(), static_cast<size_t>(status.st_size),
+                            crc)) {
+    return true;
+  }
+  // Pipes, devices, empty files or files which can not be mapped.
+  return detail::ConsumeBuffered(fd.get(), crc);
+#else
+  std::basic_ifstream<char> file(path,
+                                 std::ios_base::in | std::ios_base::binary);
+  if (!file) {
+    return false;
+  }
+  std::vector<char> buffer(kFileBlockSize);
+  while (file) {
+    file.read(buffer.data(), buffer.size());
+    crc.Consume(buffer.data(), static_cast<size_t>(file.gcount()));
+  }
+  return file.eof();
+#endif
+}
+
+template <typename T>
+std::optional<T> ChecksumFile(const std::string& path,
+                              const OptionsCrc& options) {
+  Crc<T> crc(options);
+  if (!ConsumeFile(path, crc)) {
+    return std::nullopt;
+  }
+  return crc.crc();
+}
+
+}  // namespace hash
+
+#endif  // CHECKSUM_FILE_H_
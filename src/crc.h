@@ -1,9 +1,37 @@
 #ifndef CRC_H_
 #define CRC_H_
 
-#include <chrono>       // std::chrono::system_clock / duration
-#include <numeric>      // std::accumulate
+#include <algorithm>    // std::min
+#include <array>        // std::array
+#include <atomic>       // std::atomic
+#include <cassert>      // assert
+#include <chrono>       // std::chrono::steady_clock / duration
+#include <cstdlib>      // std::getenv
+#include <cstring>      // std::memcpy
+#include <fstream>      // std::ifstream / std::ofstream
+#include <iterator>     // std::size
+#include <map>          // std::map
+#include <memory>       // std::unique_ptr
+#include <mutex>        // std::call_once / std::mutex
+#include <sstream>      // std::istringstream / std::ostringstream
+#include <string>       // std::string
+#include <string_view>  // std::string_view
+#include <tuple>        // std::tuple
 #include <type_traits>  // std::enable_if
+#include <vector>       // std::vector
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HASHLIB_POSIX_IOVEC 1
+#include <sys/uio.h>  // iovec
+#endif
+
+#include "crc_hw.h"
+
+// Define to 1 to collect CrcStats of every Crc instance. Disabled counters
+// cost nothing, the instance does not even contain them.
+#ifndef HASHLIB_CRC_STATS
+#define HASHLIB_CRC_STATS 0
+#endif
 
 namespace hash {
 
@@ -12,16 +40,39 @@ enum CrcChunks {
   CHUNKS_1x32b,
   CHUNKS_2x32b,
   CHUNKS_4x32b,
-  CHUNKS_8x32b
+  CHUNKS_8x32b,
+  // Native 64-bit words, mostly useful for 64-bit CRC, which fills the whole
+  // word with the register.
+  CHUNKS_1x64b,
+  CHUNKS_2x64b,
+  CHUNKS_4x64b,
+  // Table lookups with AVX2 / AVX-512 gathers over 16 interleaved streams,
+  // merged like Combine(). Only for 32-bit CRC and data of at least
+  // 16 * kGatherSegment bytes, otherwise falls back to CHUNKS_8x32b.
+  SIMD_GATHER,
+  // Hardware accelerated processing (crc32 instruction for CRC32C and on ARM
+  // also CRC32, carry-less multiplication folding for other polynomials).
+  // Falls back to CHUNKS_8x32b when required instructions are not available.
+  HW_CLMUL,
+  // Use processing method selected for the whole process by CrcDispatcher.
+  CHUNKS_AUTO
 };
 
 struct OptionsCrc {
   constexpr OptionsCrc(uint64_t _polynomial, uint64_t _initial_crc,
                        uint64_t _xor_output, bool _reverse_data,
-                       bool _reverse_out, CrcChunks _chunks = CHUNKS_4x32b);
+                       bool _reverse_out, CrcChunks _chunks = CHUNKS_AUTO,
+                       uint8_t _width = 0);
+  static constexpr OptionsCrc Crc8();
+  static constexpr OptionsCrc Crc8_MAXIM();
+  static constexpr OptionsCrc Crc15_CAN();
   static constexpr OptionsCrc Crc16();
   static constexpr OptionsCrc Crc16_CCITT();
+  static constexpr OptionsCrc Crc24_OPENPGP();
+  static constexpr OptionsCrc Crc24_BLE();
   static constexpr OptionsCrc Crc32();
+  static constexpr OptionsCrc Crc32C();
+  static constexpr OptionsCrc Crc40_GSM();
   static constexpr OptionsCrc Crc64();
   static constexpr OptionsCrc Crc64_ISO();
   const uint64_t polynomial = 0;
@@ -29,152 +80,791 @@ struct OptionsCrc {
   const uint64_t xor_output = 0;
   const bool reverse_data = false;
   const bool reverse_out = false;
-  CrcChunks chunks = CHUNKS_4x32b;
+  CrcChunks chunks = CHUNKS_AUTO;
+  // Number of bits of the CRC, up to the width of the type used by Crc<T>.
+  // 0 stands for the whole type. Narrower registers are aligned to the most
+  // significant bit of the type, so all processing methods apply unchanged.
+  const uint8_t width = 0;
 };
 
 constexpr OptionsCrc::OptionsCrc(uint64_t _polynomial, uint64_t _initial_crc,
                                  uint64_t _xor_output, bool _reverse_data,
-                                 bool _reverse_out, CrcChunks _chunks)
+                                 bool _reverse_out, CrcChunks _chunks,
+                                 uint8_t _width)
     : polynomial(_polynomial),
       initial_crc(_initial_crc),
       xor_output(_xor_output),
       reverse_data(_reverse_data),
       reverse_out(_reverse_out),
-      chunks(_chunks) {}
+      chunks(_chunks),
+      width(_width) {}
+
+// Maximum number of lookup table slices, used by CHUNKS_8x32b / 4x64b.
+constexpr size_t kMaxTableSlices = 32;
+
+// Distance between streams of SIMD_GATHER method.
+constexpr size_t kGatherSegment = 16 * 1024;
 
+// Data smaller than this is consumed by ConsumeParallel() on the calling
+// thread, as the synchronization would cost more than it saves.
+constexpr size_t kParallelThreshold = 1024 * 1024;
+// Minimum size of the chunk processed by a single ConsumeParallel() task.
+constexpr size_t kMinParallelChunk = 256 * 1024;
+// Segments of chained data shorter than this are gathered by Consume() into
+// blocks of this size, so the kernels are not called for every short segment.
+constexpr size_t kChainCarrySize = 256;
+// Long segments are consumed in place in multiples of this many bytes, the
+// rest is carried over to the next segment.
+constexpr size_t kChainWordSize = 64;
+// CopyAndConsume() copies and consumes data in tiles of this size, so the
+// source is loaded from memory once.
+constexpr size_t kCopyTileSize = 16 * 1024;
+// Copies of at least this many bytes use non-temporal stores, the
+// destination would not stay in cache anyway.
+constexpr size_t kStreamingCopyThreshold = 1024 * 1024;
+// Blocks checked by one batch of VerifyBlocks() before comparing results.
+constexpr size_t kVerifyBatchSize = 64;
+
+// Upper bounds of message size classes, the last class is unbounded. Setup
+// costs of the wide methods dominate short messages, so CrcDispatcher selects
+// processing method for every class separately.
+constexpr size_t kSizeClassLimits[] = {64, 512, 4 * 1024, 64 * 1024};
+constexpr size_t kSizeClasses = std::size(kSizeClassLimits) + 1;
+
+// Index of the size class of message with 'size' bytes.
+constexpr size_t SizeClass(size_t size) noexcept {
+  size_t size_class = 0;
+  while (size_class < std::size(kSizeClassLimits) &&
+         size > kSizeClassLimits[size_class]) {
+    ++size_class;
+  }
+  return size_class;
+}
+
+// Lookup tables shared by all Crc instances with the same type, polynomial
+// and data ordering. Only slices used by the processing method are present.
 template <typename T>
-class Crc {
- public:
-  Crc() = delete;
-  Crc(const OptionsCrc& options = OptionsCrc::Crc32());
-  ~Crc() = default;
+struct CrcTable {
+  // Memory used by lookup table slices in bytes.
+  constexpr size_t footprint() const noexcept {
+    return slices * sizeof(*lookup);
+  }
 
-  // Consume specified number of elements from given array of any type.
-  template <typename Y>
-  void Consume(const Y* data, size_t size);
-  // Use not default processing method.
-  template <typename Y>
-  void Consume(const Y* data, size_t size, CrcChunks chunks);
+  // Checksums of all 8-bit values followed by 0..slices-1 zero bytes.
+  const T (*lookup)[256] = nullptr;
+  size_t slices = 0;
+  // Constants for hardware folding (HW_CLMUL).
+  hw::FoldConstants fold;
+  T polynomial = 0;
+};
 
-  // Optimize CRC calculation by selecting processing method with most
-  // performance. Calculate performance for 128 packages with 8kB of data.
-  void Optimize(uint64_t buffer_size = 8 * 1024 - 1, uint64_t repeats = 128);
+// Independent message processed by Crc::ChecksumBatch(), or a segment of
+// chained data consumed by Crc::Consume().
+struct CrcBuffer {
+  const void* data = nullptr;
+  size_t size = 0;
+};
 
-  // Retrieve CRC value.
-  T crc() const noexcept;
-  // Reset CRC value to initial one.
-  void reset() noexcept;
+// Counters of data consumed by a Crc instance, collected when
+// HASHLIB_CRC_STATS is 1. Plain values, so they can be copied out, merged and
+// exported to a metrics system.
+struct CrcStats {
+  // Every method except CHUNKS_AUTO, which is always resolved first.
+  static constexpr size_t kMethods = CHUNKS_AUTO;
+  static constexpr size_t kSizeBuckets = 32;
 
- private:
-  void GenerateLookupTable() noexcept;
-  T CalculateTableValue(uint8_t value) const noexcept;
-  T ReverseBits(T value, size_t bits = sizeof(T) * 8) const noexcept;
-  template <typename Y>
-  void Consume_byte_by_byte(const Y* data, size_t size);
-  template <typename Y>
-  void Consume_1x32b(const Y* data, size_t size);
-  template <typename Y>
-  void Consume_2x32b(const Y* data, size_t size);
-  template <typename Y>
-  void Consume_4x32b(const Y* data, size_t size);
-  template <typename Y>
-  void Consume_8x32b(const Y* data, size_t size);
+  // Consumed bytes and number of calls by processing method.
+  uint64_t bytes[kMethods] = {};
+  uint64_t calls[kMethods] = {};
+  // Number of calls by size: bucket 0 counts empty calls, bucket i sizes in
+  // [2^(i-1), 2^i). The last bucket counts all larger sizes too.
+  uint64_t size_histogram[kSizeBuckets] = {};
+  // Time spent consuming, in hw::ReadCycles() units.
+  uint64_t cycles = 0;
 
-  T crc_;
-  const T initial_crc_;
-  const T xor_output_;
-  const T polynomial_;
-  const bool reverse_data_;
-  const bool reverse_out_;
-  T lookup_table_[32][256];
-  CrcChunks chunks_;
+  void Record(CrcChunks chunks, size_t size, uint64_t elapsed) noexcept;
+  CrcStats& operator+=(const CrcStats& other) noexcept;
 };
 
+inline void CrcStats::Record(CrcChunks chunks, size_t size,
+                             uint64_t elapsed) noexcept {
+  if (chunks < kMethods) {
+    bytes[chunks] += size;
+    ++calls[chunks];
+  }
+  size_t bucket = 0;
+  for (; size > 0 && bucket < kSizeBuckets - 1; size >>= 1) {
+    ++bucket;
+  }
+  ++size_histogram[bucket];
+  cycles += elapsed;
+}
+
+inline CrcStats& CrcStats::operator+=(const CrcStats& other) noexcept {
+  for (size_t i = 0; i < kMethods; ++i) {
+    bytes[i] += other.bytes[i];
+    calls[i] += other.calls[i];
+  }
+  for (size_t i = 0; i < kSizeBuckets; ++i) {
+    size_histogram[i] += other.size_histogram[i];
+  }
+  cycles += other.cycles;
+  return *this;
+}
+
+// Number of lookup table slices required by the processing method.
+inline size_t TableSlices(CrcChunks chunks) noexcept {
+  switch (chunks) {
+    case BYTE_BY_BYTE:
+      return 1;
+    case CHUNKS_1x32b:
+      return 4;
+    case CHUNKS_2x32b:
+      return 8;
+    case CHUNKS_4x32b:
+      return 16;
+    case CHUNKS_1x64b:
+      return 8;
+    case CHUNKS_2x64b:
+      return 16;
+    case HW_CLMUL:
+      // Only the 16 byte remainder and short data are processed with tables,
+      // by 32-bit words.
+      return hw::GetCpuFeatures().clmul ? 4 : kMaxTableSlices;
+    case CHUNKS_8x32b:
+    case CHUNKS_4x64b:
+    case SIMD_GATHER:
+    case CHUNKS_AUTO:
+      break;
+  }
+  return kMaxTableSlices;
+}
+
+// Memory used by lookup tables of Crc<T> with given processing method.
 template <typename T>
-Crc<T>::Crc(const OptionsCrc& options)
-    : crc_((options.reverse_data)
-               ? ReverseBits(static_cast<T>(options.initial_crc))
-               : static_cast<T>(options.initial_crc)),
-      initial_crc_(static_cast<T>(options.initial_crc)),
-      xor_output_(static_cast<T>(options.xor_output)),
-      polynomial_(static_cast<T>(options.polynomial)),
-      reverse_data_(options.reverse_data),
-      reverse_out_(options.reverse_out),
-      chunks_(options.chunks) {
-  GenerateLookupTable();
+size_t TableFootprint(CrcChunks chunks) noexcept {
+  return TableSlices(chunks) * 256 * sizeof(T);
+}
+
+namespace detail {
+
+// Fastest processing method, which does not require more table slices than
+// available. Allows to consume data without growing the table.
+inline CrcChunks FitTable(CrcChunks chunks, size_t slices) noexcept {
+  if (TableSlices(chunks) <= slices) {
+    return chunks;
+  }
+  if (slices >= 16) {
+    return CHUNKS_4x32b;
+  }
+  if (slices >= 8) {
+    return CHUNKS_2x32b;
+  }
+  if (slices >= 4) {
+    return CHUNKS_1x32b;
+  }
+  return BYTE_BY_BYTE;
+}
+
+// Reverse bits in the 'value' parameter.
+// If bits == sizeof(T) - reverse all bits
+// 1000000011000011
+// 1100001100000001 - all bits
+// If bits < sizeof(T) only Reflect in range of specified bit size.
+// 0000000011111001
+// 0000000010011111 - only first 8 bits
+template <typename T>
+constexpr T ReverseBits(T value, size_t bits = sizeof(T) * 8) noexcept {
+  T reverse = 0;
+  for (size_t i = 0; i < bits; ++i) {
+    if (value & 1) {
+      reverse |= (static_cast<T>(1) << ((bits - 1) - i));
+    }
+    value >>= 1;
+  }
+  return reverse;
+}
+
+template <typename T>
+constexpr T CalculateTableValue(T polynomial, bool reflected,
+                                uint8_t value) noexcept {
+  constexpr uint8_t bits = sizeof(T) * 8;
+  constexpr T high_bit = static_cast<T>(1) << (bits - 1);
+  T result = static_cast<T>(value);
+  if (reflected) {
+    result = static_cast<T>(ReverseBits(value, 8));
+  }
+  result <<= (bits - 8);
+
+  for (size_t i = 0; i < 8; ++i) {
+    if (result & high_bit) {
+      result <<= 1;
+      result ^= polynomial;
+    } else {
+      result <<= 1;
+    }
+  }
+
+  if (reflected) {
+    return ReverseBits(result);
+  }
+  return result;
+}
+
+// Calculate a * b mod P, where P is the CRC polynomial. All values use
+// normal (not reflected) bit ordering.
+template <typename T>
+constexpr T MultiplyMod(T a, T b, T polynomial) noexcept {
+  constexpr T high_bit = static_cast<T>(1) << (sizeof(T) * 8 - 1);
+  T result = 0;
+  for (T mask = high_bit; mask != 0; mask >>= 1) {
+    result = (result & high_bit) ? static_cast<T>(result << 1) ^ polynomial
+                                 : static_cast<T>(result << 1);
+    if (b & mask) {
+      result ^= a;
+    }
+  }
+  return result;
+}
+
+// Calculate x^n mod P, where P is the CRC polynomial. Uses exponentiation by
+// squaring, so cost is logarithmic in 'n'.
+template <typename T>
+constexpr T XPowMod(T polynomial, uint64_t n) noexcept {
+  T result = 1;
+  T square = 2;
+  for (; n > 0; n >>= 1) {
+    if (n & 1) {
+      result = MultiplyMod(result, square, polynomial);
+    }
+    square = MultiplyMod(square, square, polynomial);
+  }
+  return result;
+}
+
+// Combine CRC values of two consecutive blocks of data into CRC of both, where
+// 'crc_b' was calculated over 'size_b' bytes. CRC values are converted back
+// to registers with normal bit ordering: (A ^ init) * x^(8 * size_b) ^ B.
+template <typename T>
+constexpr T CombineCrc(T crc_a, T crc_b, uint64_t size_b, T polynomial,
+                       T initial_crc, T xor_output, bool reverse_out) noexcept {
+  const auto to_register = [&](T crc) {
+    crc ^= xor_output;
+    return (reverse_out) ? ReverseBits(crc) : crc;
+  };
+  const T combined =
+      MultiplyMod(static_cast<T>(to_register(crc_a) ^ initial_crc),
+                  XPowMod(polynomial, 8 * size_b), polynomial) ^
+      to_register(crc_b);
+  return ((reverse_out) ? ReverseBits(combined) : combined) ^ xor_output;
+}
+
+// Multiply register by 'x_pow' (x^n mod P), as if 'n' zero bits were consumed.
+// Register uses data ordering, while 'x_pow' has normal bit ordering.
+template <typename T>
+constexpr T ShiftRegister(T crc, T x_pow, T polynomial,
+                          bool reflected) noexcept {
+  if (reflected) {
+    return ReverseBits(MultiplyMod(ReverseBits(crc), x_pow, polynomial));
+  }
+  return MultiplyMod(crc, x_pow, polynomial);
+}
+
+// Folding multiplies 64-bit halves of the 128-bit accumulator by x^n mod P.
+// Product of reflected values is shifted by one bit, which is compensated by
+// using x^(n-1) mod P instead. Reflected constants are aligned to 64 bits.
+template <typename T>
+constexpr uint64_t FoldConstant(T polynomial, bool reflected,
+                                uint64_t n) noexcept {
+  constexpr uint8_t align = 64 - (sizeof(T) * 8);
+  if (reflected) {
+    return static_cast<uint64_t>(ReverseBits(XPowMod(polynomial, n - 1)))
+           << align;
+  }
+  return XPowMod(polynomial, n);
 }
 
 // Generates a lookup table for the checksums of all 8-bit values.
 // Values can be genrated using reversed bit ordering depending on the
 // standard.
 template <typename T>
-void Crc<T>::GenerateLookupTable() noexcept {
+constexpr void GenerateLookupTable(T polynomial, bool reflected,
+                                   T (*lookup)[256], size_t slices) noexcept {
   for (size_t i = 0; i < 256; ++i) {
-    lookup_table_[0][i] = CalculateTableValue(static_cast<uint8_t>(i));
+    lookup[0][i] =
+        CalculateTableValue(polynomial, reflected, static_cast<uint8_t>(i));
   }
   // Precompute additional values, to allow computation with more 64b
   // chunks of data at the same time.
-  if (reverse_data_) {
+  if (reflected) {
     for (size_t i = 0; i < 256; ++i) {
-      for (size_t j = 1; j < 32; ++j) {
-        lookup_table_[j][i] = (lookup_table_[j - 1][i] >> 8) ^
-                              lookup_table_[0][lookup_table_[j - 1][i] & 0xFF];
+      for (size_t j = 1; j < slices; ++j) {
+        lookup[j][i] =
+            (lookup[j - 1][i] >> 8) ^ lookup[0][lookup[j - 1][i] & 0xFF];
       }
     }
   } else {
-    constexpr static uint8_t shift = (sizeof(T) * 8) - 8;
+    constexpr uint8_t shift = (sizeof(T) * 8) - 8;
     for (size_t i = 0; i < 256; ++i) {
-      for (size_t j = 1; j < 32; ++j) {
-        lookup_table_[j][i] =
-            (lookup_table_[j - 1][i] << 8) ^
-            lookup_table_[0][(lookup_table_[j - 1][i] >> shift) & 0xFF];
+      for (size_t j = 1; j < slices; ++j) {
+        lookup[j][i] = static_cast<T>(lookup[j - 1][i] << 8) ^
+                       lookup[0][(lookup[j - 1][i] >> shift) & 0xFF];
       }
     }
   }
 }
 
 template <typename T>
-T Crc<T>::CalculateTableValue(uint8_t value) const noexcept {
-  constexpr static uint8_t bits = sizeof(T) * 8;
-  constexpr static T high_bit = static_cast<T>(1) << (bits - 1);
-  T result = static_cast<T>(value);
-  if (reverse_data_) {
-    result = static_cast<T>(ReverseBits(value, 8));
-  }
-  result <<= (bits - 8);
+constexpr hw::FoldConstants GenerateFoldConstants(T polynomial,
+                                                  bool reflected) noexcept {
+  // Low and high 64-bit halves are swapped for reflected data.
+  hw::FoldConstants fold;
+  fold.fold_512_lo =
+      FoldConstant(polynomial, reflected, reflected ? 512 + 64 : 512);
+  fold.fold_512_hi =
+      FoldConstant(polynomial, reflected, reflected ? 512 : 512 + 64);
+  fold.fold_128_lo =
+      FoldConstant(polynomial, reflected, reflected ? 128 + 64 : 128);
+  fold.fold_128_hi =
+      FoldConstant(polynomial, reflected, reflected ? 128 : 128 + 64);
+  return fold;
+}
 
-  for (size_t i = 0; i < 8; ++i) {
-    if (result & high_bit) {
-      result <<= 1;
-      result ^= polynomial_;
+// Storage for lookup table slices generated at compile time.
+template <typename T, size_t slices>
+struct LookupSlices {
+  T values[slices][256] = {};
+};
+
+template <typename T, size_t slices>
+constexpr LookupSlices<T, slices> GenerateLookupSlices(T polynomial,
+                                                        bool reflected) {
+  LookupSlices<T, slices> result;
+  GenerateLookupTable(polynomial, reflected, result.values, slices);
+  return result;
+}
+
+// Register value for given initial CRC.
+template <typename T>
+constexpr T InitialRegister(T initial_crc, bool reverse_data) noexcept {
+  return (reverse_data) ? ReverseBits(initial_crc) : initial_crc;
+}
+
+// Number of unused low bits of the register with CRC of given width.
+template <typename T>
+constexpr uint8_t RegisterShift(uint8_t width) noexcept {
+  constexpr uint8_t bits = sizeof(T) * 8;
+  return (width == 0 || width >= bits) ? 0 : bits - width;
+}
+
+// Align polynomial or initial value of CRC with given width to the most
+// significant bit of the register.
+template <typename T>
+constexpr T AlignRegister(uint64_t value, uint8_t width) noexcept {
+  return static_cast<T>(static_cast<T>(value) << RegisterShift<T>(width));
+}
+
+// Shift of the CRC value produced by the aligned register. Reflected output
+// already moves it to the least significant bits.
+template <typename T>
+constexpr uint8_t OutputShift(uint8_t width, bool reverse_out) noexcept {
+  return (reverse_out) ? 0 : RegisterShift<T>(width);
+}
+
+// CRC value for given register.
+template <typename T>
+constexpr T FinalCrc(T crc, T xor_output, bool reverse_data,
+                     bool reverse_out) noexcept {
+  return (reverse_out ^ reverse_data) ? ReverseBits(crc) ^ xor_output
+                                      : crc ^ xor_output;
+}
+
+// Register 'crc' updated with 'data' byte by byte. Usable in constant
+// expressions, which can not load the data as words.
+template <typename T>
+constexpr T ConsumeConstexpr(const T (*lookup)[256], T crc, bool reflected,
+                             std::string_view data) noexcept {
+  constexpr uint8_t shift = (sizeof(T) * 8) - 8;
+  for (const char value : data) {
+    const auto byte = static_cast<uint8_t>(value);
+    if (reflected) {
+      crc = static_cast<T>(crc >> 8) ^ lookup[0][(crc ^ byte) & 0xFF];
     } else {
-      result <<= 1;
+      crc = static_cast<T>(crc << 8) ^
+            lookup[0][((crc >> shift) ^ byte) & 0xFF];
     }
   }
+  return crc;
+}
 
-  if (reverse_data_) {
-    return ReverseBits(result);
+// Tables of the predefined CRC options, generated at compile time. Views with
+// less slices share the same storage.
+template <typename T, uint64_t polynomial, bool reflected>
+struct StaticCrcTable {
+  static constexpr LookupSlices<T, kMaxTableSlices> storage =
+      GenerateLookupSlices<T, kMaxTableSlices>(static_cast<T>(polynomial),
+                                               reflected);
+  static constexpr hw::FoldConstants fold =
+      GenerateFoldConstants(static_cast<T>(polynomial), reflected);
+  static constexpr CrcTable<T> View(size_t slices) {
+    return {storage.values, slices, fold, static_cast<T>(polynomial)};
   }
-  return result;
-}
+  static constexpr CrcTable<T> views[] = {View(1), View(4), View(8), View(16),
+                                          View(kMaxTableSlices)};
+  static constexpr const CrcTable<T>& value = views[4];
 
-// Reverse bits in the 'value' parameter.
-// If bits == sizeof(T) - reverse all bits
-// 1000000011000011
-// 1100001100000001 - all bits
-// If bits < sizeof(T) only Reflect in range of specified bit size.
-// 0000000011111001
-// 0000000010011111 - only first 8 bits
-template <typename T>
-T Crc<T>::ReverseBits(T value, size_t bits) const noexcept {
-  T reverse = 0;
-  for (size_t i = 0; i < bits; ++i) {
-    if (value & 1) {
-      reverse |= (static_cast<T>(1) << ((bits - 1) - i));
+  static constexpr const CrcTable<T>* Get(size_t slices) noexcept {
+    for (const CrcTable<T>& view : views) {
+      if (view.slices >= slices) {
+        return &view;
+      }
     }
-    value >>= 1;
+    return &value;
   }
-  return reverse;
+};
+
+// Retrieve shared table with at least 'slices' slices. Predefined options use
+// tables generated at compile time, others are generated once per process on
+// first use.
+template <typename T>
+const CrcTable<T>* GetCrcTable(T polynomial, bool reflected, size_t slices);
+
+// Bytes of a segment of chained data.
+inline const uint8_t* SegmentData(const CrcBuffer& segment) noexcept {
+  return static_cast<const uint8_t*>(segment.data);
+}
+inline size_t SegmentSize(const CrcBuffer& segment) noexcept {
+  return segment.size;
+}
+#if defined(HASHLIB_POSIX_IOVEC)
+inline const uint8_t* SegmentData(const iovec& segment) noexcept {
+  return static_cast<const uint8_t*>(segment.iov_base);
+}
+inline size_t SegmentSize(const iovec& segment) noexcept {
+  return segment.iov_len;
+}
+#endif
+
+}  // namespace detail
+
+template <typename T>
+class Crc {
+ public:
+  Crc() = delete;
+  Crc(const OptionsCrc& options = OptionsCrc::Crc32());
+  ~Crc() = default;
+
+  // Consume specified number of elements from given array of any type.
+  // Never allocates: if the process wide method selected later requires more
+  // table slices than reserved by this instance, the fastest method fitting
+  // the current table is used instead.
+  template <typename Y>
+  void Consume(const Y* data, size_t size) noexcept;
+  // Use not default processing method. May allocate the table on first use.
+  template <typename Y>
+  void Consume(const Y* data, size_t size, CrcChunks chunks);
+  // Consume 'count' segments of chained data, as if they were contiguous.
+  // Partial words are carried across segment boundaries, so the kernels run
+  // on long blocks regardless of how the data is split. Never allocates.
+  void Consume(const CrcBuffer* segments, size_t count) noexcept;
+#if defined(HASHLIB_POSIX_IOVEC)
+  void Consume(const iovec* segments, size_t count) noexcept;
+#endif
+  // Copy 'size' elements from 'src' to 'dst' like memcpy and consume them in
+  // the same pass. Each tile is consumed while it is still cached from the
+  // copy. Buffers must not overlap.
+  template <typename Y>
+  void CopyAndConsume(Y* dst, const Y* src, size_t size) noexcept;
+  // Split data into chunks consumed concurrently by 'pool' and the calling
+  // thread, then merge the partial results. 'Pool' has to provide size() and
+  // Submit(task) returning a future of the task result (see ThreadPool).
+  // Data smaller than 'threshold' bytes is consumed on the calling thread.
+  template <typename Y, typename Pool>
+  void ConsumeParallel(const Y* data, size_t size, Pool& pool,
+                       size_t threshold = kParallelThreshold);
+
+  // Calculate CRC of every buffer independently, as if each one was consumed
+  // after reset(), and store it in 'results'. Buffers are processed in
+  // interleaved lanes, so latency of the short messages overlaps. Current CRC
+  // value is not modified.
+  void ChecksumBatch(const CrcBuffer* buffers, size_t count, T* results) const;
+  template <size_t N>
+  std::array<T, N> ChecksumBatch(const std::array<CrcBuffer, N>& buffers) const;
+  // Check 'count' consecutive blocks of 'block_size' bytes against their
+  // 'expected' CRC values, as if each block was consumed after reset().
+  // Blocks are processed in batches of interleaved lanes, and stop at the
+  // first batch with a mismatch. Returns index of the first mismatching
+  // block, or 'count' if all match. Current CRC value is not modified.
+  size_t VerifyBlocks(const void* data, size_t block_size, const T* expected,
+                      size_t count) const;
+
+  // Optimize CRC calculation by selecting processing method with most
+  // performance for every message size class, then follow the selection.
+  // Every method consumes 'buffer_size' * 'repeats' bytes per size class.
+  // Measurement is done only once per process for given type and data
+  // ordering, next calls reuse the result (see CrcDispatcher).
+  void Optimize(uint64_t buffer_size = 8 * 1024 - 1, uint64_t repeats = 128);
+
+  // Retrieve CRC value.
+  T crc() const noexcept;
+  // Reset CRC value to initial one.
+  void reset() noexcept;
+
+  // Calculate CRC of two consecutive blocks of data from their CRC values,
+  // without reading the data again. 'crc_b' covers 'size_b' bytes.
+  T Combine(T crc_a, T crc_b, uint64_t size_b) const noexcept;
+
+  // Adjust 'crc' of a message with 'total_size' bytes after 'size' elements
+  // at byte 'offset' were changed from 'old_data' to 'new_data'. CRC is
+  // linear, so only the difference of the changed bytes is consumed and then
+  // shifted over the rest of the message: O(size + log(total_size)).
+  // Changed bytes have to be within the message, i.e. offset + size *
+  // sizeof(Y) <= total_size, otherwise 'crc' is returned unchanged.
+  template <typename Y>
+  T Update(T crc, uint64_t offset, const Y* old_data, const Y* new_data,
+           size_t size, uint64_t total_size) const noexcept;
+
+  // Memory used by lookup tables of the currently selected processing method.
+  size_t table_footprint() const noexcept;
+
+  // Counters of data consumed by Consume() and ConsumeParallel(). Always zero
+  // unless HASHLIB_CRC_STATS is 1.
+  const CrcStats& stats() const noexcept;
+  void reset_stats() noexcept;
+
+ private:
+  // Make sure table contains all slices required by the processing method.
+  void ReserveTable(CrcChunks chunks);
+  // Consume bytes with the current table, which has to support 'chunks'.
+  void ConsumeBytes(const uint8_t* data, size_t size,
+                    CrcChunks chunks) noexcept;
+  // Processing method for 'size' bytes, which fits the current table.
+  CrcChunks Resolve(size_t size) const noexcept;
+  // Register 'crc' updated with bytes by 'table', a copy of the current one.
+  T Advance(const CrcTable<T>& table, T crc, const uint8_t* data, size_t size,
+            CrcChunks chunks) const noexcept;
+  // CRC value of register 'crc'.
+  T Finalize(T crc) const noexcept;
+  template <typename Segment>
+  void ConsumeChain(const Segment* segments, size_t count) noexcept;
+  // Registers of independent buffers, before the output transformation.
+  void BatchRegisters(const CrcBuffer* buffers, size_t count,
+                      T* registers) const;
+
+  // Instance holds the state only, tables are shared. Members are not const,
+  // so running CRCs can be copied and assigned freely.
+  // Polynomial, initial value and output xor are aligned to the register.
+  T crc_;
+  T initial_crc_;
+  T xor_output_;
+  T polynomial_;
+  bool reverse_data_;
+  bool reverse_out_;
+  // Shift converting register sized CRC value to the value of given width.
+  uint8_t out_shift_;
+  const CrcTable<T>* table_;
+  CrcChunks chunks_;
+#if HASHLIB_CRC_STATS
+  CrcStats stats_;
+#endif
+
+  template <typename Y>
+  friend class CrcEngine;
+};
+
+static_assert(std::is_trivially_copyable<Crc<uint32_t>>::value,
+              "Crc snapshots have to be cheap to copy.");
+
+// Process wide selection of the processing method for every message size
+// class, shared by all Crc instances with the same type and data ordering.
+// Initial choice is based on CPU features only, so it costs nothing.
+// Calibrate() can refine it once with a micro-benchmark.
+template <typename T>
+class CrcDispatcher {
+ public:
+  CrcDispatcher() = delete;
+
+  // Processing method selected for messages of 'size' bytes.
+  static CrcChunks Get(bool reverse_data, size_t size) noexcept;
+  // Processing method selected for the longest messages.
+  static CrcChunks Get(bool reverse_data) noexcept;
+  // Table slices required by the methods of all size classes.
+  static size_t Slices(bool reverse_data) noexcept;
+  // Measure all processing methods with 'crc' parameters on a message of
+  // every size class, consuming 'bytes' bytes per method, and select the
+  // fastest ones. Measurement is run only by the first call in the process.
+  // Selection of calibrated or pinned dispatchers is not measured again.
+  static void Calibrate(const Crc<T>& crc, bool reverse_data, uint64_t bytes);
+  // Force given method for every size class, e.g. loaded from a profile.
+  // Instances never allocate in Consume(), so the ones created before fall
+  // back to a method fitting their table if it is too small.
+  static void Pin(bool reverse_data,
+                  const CrcChunks (&chunks)[kSizeClasses]) noexcept;
+  // Whether the selection was calibrated or pinned.
+  static bool Fixed(bool reverse_data) noexcept;
+
+ private:
+  // Selection of both data orderings, initialized from the environment
+  // profile (see LoadCrcProfile) or by Detect().
+  struct Selection {
+    Selection();
+    std::atomic<CrcChunks> chunks[2][kSizeClasses];
+    std::atomic<bool> fixed[2];
+  };
+
+  static CrcChunks Detect() noexcept;
+  static CrcChunks Measure(const Crc<T>& crc, size_t size, uint64_t bytes);
+  static Selection& Selections() noexcept;
+  static std::atomic<CrcChunks>& Selected(bool reverse_data,
+                                          size_t size_class) noexcept;
+};
+
+// Calibration profile lists methods selected by CrcDispatcher, one line per
+// register type and data ordering followed by the method of every size
+// class, e.g.
+//   crc32 reflected HW_CLMUL HW_CLMUL HW_CLMUL HW_CLMUL HW_CLMUL
+//   crc64 normal CHUNKS_1x64b CHUNKS_4x32b CHUNKS_4x32b ...
+// Lines starting with '#' are comments. Loaded selections are pinned, so a
+// profile saved once per host after Optimize() lets next processes start
+// without calibration. On first use, every CrcDispatcher loads the profile
+// file named by HASHLIB_CRC_PROFILE environment variable, and then pins the
+// method named by HASHLIB_CRC_METHOD (e.g. CHUNKS_8x32b) for all classes.
+// Malformed environment profile is ignored.
+
+// Profile of all calibrated or pinned dispatchers.
+std::string SaveCrcProfile();
+// Pin selections listed in 'profile'. Returns false, without changing any
+// selection, if the profile is malformed.
+bool LoadCrcProfile(const std::string& profile);
+// Same for a file. Return false if the file can not be written or read.
+bool SaveCrcProfileFile(const std::string& path);
+bool LoadCrcProfileFile(const std::string& path);
+
+// Name of the processing method, e.g. "CHUNKS_8x32b".
+const char* CrcChunksName(CrcChunks chunks) noexcept;
+
+namespace detail {
+
+// Processing methods shared by Crc and StaticCrc. Data ordering is a template
+// parameter, so the hot loops do not branch on it.
+template <typename T, bool reflected>
+struct CrcKernels {
+  // Update 'crc' register with 'size' bytes of data.
+  static T Consume(const CrcTable<T>& table, T crc, const uint8_t* data,
+                   size_t size, CrcChunks chunks);
+
+  static T Consume_byte_by_byte(const CrcTable<T>& table, T crc,
+                                const uint8_t* data, size_t size);
+  static T Consume_1x32b(const CrcTable<T>& table, T crc, const uint8_t* data,
+                         size_t size);
+  static T Consume_2x32b(const CrcTable<T>& table, T crc, const uint8_t* data,
+                         size_t size);
+  static T Consume_4x32b(const CrcTable<T>& table, T crc, const uint8_t* data,
+                         size_t size);
+  static T Consume_8x32b(const CrcTable<T>& table, T crc, const uint8_t* data,
+                         size_t size);
+  static T Consume_1x64b(const CrcTable<T>& table, T crc, const uint8_t* data,
+                         size_t size);
+  static T Consume_2x64b(const CrcTable<T>& table, T crc, const uint8_t* data,
+                         size_t size);
+  static T Consume_4x64b(const CrcTable<T>& table, T crc, const uint8_t* data,
+                         size_t size);
+  static T Consume_gather(const CrcTable<T>& table, T crc,
+                          const uint8_t* data, size_t size);
+  static T Consume_hw(const CrcTable<T>& table, T crc, const uint8_t* data,
+                      size_t size);
+
+  // Consume bytes preceding the first word of data aligned to 'alignment'.
+  static T ConsumeHead(const CrcTable<T>& table, T crc, const uint8_t** data,
+                       size_t* size, size_t alignment = alignof(uint32_t));
+  // Consume remaining 32-bit words followed by remaining bytes.
+  static T ConsumeTail(const CrcTable<T>& table, T crc, const uint8_t* data,
+                       size_t size);
+  // Update register with single 32-bit word of data.
+  static T Step_1x32b(const CrcTable<T>& table, T crc, uint32_t word);
+  // Register bytes in the order of data within 64-bit word.
+  static uint64_t Register_64b(T crc) noexcept;
+
+  // Calculate registers of independent buffers, starting from 'crc'.
+  static void ConsumeBatch(const CrcTable<T>& table, T crc,
+                           const CrcBuffer* buffers, size_t count,
+                           CrcChunks chunks, T* results);
+  // Process buffers in 'lanes_count' lanes, each advanced by 'kernel' with
+  // the same multiple of 'word' bytes.
+  template <size_t lanes_count, size_t word, typename Kernel>
+  static void ConsumeBatchLanes(const CrcTable<T>& table, T crc,
+                                const CrcBuffer* buffers, size_t count,
+                                CrcChunks chunks, T* results, Kernel kernel);
+  // Update hw::kLanes independent registers, each with 'size' bytes of its
+  // own data. 'size' has to be a multiple of 8. Requires 8 table slices.
+  static void Consume_lanes(const CrcTable<T>& table, T crc[hw::kLanes],
+                            const uint8_t* const data[hw::kLanes], size_t size,
+                            CrcChunks chunks);
+  // Whether lanes of HW_CLMUL method use dedicated CRC instructions.
+  static bool HasLaneInstructions(const CrcTable<T>& table) noexcept;
+  // Update register with 8 bytes of data, as in Consume_2x32b.
+  static T Step_2x32b(const CrcTable<T>& table, T crc, const uint8_t* data);
+};
+
+}  // namespace detail
+
+// CRC with all parameters known at compile time. Uses the same processing
+// methods as Crc, but the table and data ordering are constants, so every
+// kernel is fully specialized.
+template <typename T, uint64_t polynomial, uint64_t initial_crc,
+          uint64_t xor_output, bool reverse_data, bool reverse_out>
+class StaticCrc {
+ public:
+  constexpr StaticCrc(CrcChunks chunks = CHUNKS_AUTO) noexcept;
+  ~StaticCrc() = default;
+
+  // Consume specified number of elements from given array of any type.
+  // Tables are generated at compile time, so consumption never allocates.
+  template <typename Y>
+  void Consume(const Y* data, size_t size) noexcept;
+  // Use not default processing method.
+  template <typename Y>
+  void Consume(const Y* data, size_t size, CrcChunks chunks) noexcept;
+
+  // Retrieve CRC value.
+  constexpr T crc() const noexcept;
+  // Reset CRC value to initial one.
+  constexpr void reset() noexcept;
+
+  // Calculate CRC of two consecutive blocks of data from their CRC values,
+  // without reading the data again. 'crc_b' covers 'size_b' bytes.
+  static constexpr T Combine(T crc_a, T crc_b, uint64_t size_b) noexcept;
+
+  // CRC of 'data' consumed byte by byte, so it can be evaluated at compile
+  // time, e.g. for string literals. Use Consume() for data known at runtime.
+  static constexpr T Checksum(std::string_view data) noexcept;
+
+ private:
+  using Kernels = detail::CrcKernels<T, reverse_data>;
+  using Table =
+      detail::StaticCrcTable<T, static_cast<T>(polynomial), reverse_data>;
+
+  T crc_;
+  CrcChunks chunks_;
+};
+
+template <typename T>
+Crc<T>::Crc(const OptionsCrc& options)
+    : crc_(detail::InitialRegister(
+          detail::AlignRegister<T>(options.initial_crc, options.width),
+          options.reverse_data)),
+      initial_crc_(
+          detail::AlignRegister<T>(options.initial_crc, options.width)),
+      xor_output_(static_cast<T>(
+          static_cast<T>(options.xor_output)
+          << detail::OutputShift<T>(options.width, options.reverse_out))),
+      polynomial_(detail::AlignRegister<T>(options.polynomial, options.width)),
+      reverse_data_(options.reverse_data),
+      reverse_out_(options.reverse_out),
+      out_shift_(detail::OutputShift<T>(options.width, options.reverse_out)),
+      table_(nullptr),
+      chunks_(options.chunks) {
+  ReserveTable(chunks_);
 }
 
 // Swap endianess of a given type.
@@ -217,430 +907,1556 @@ T SwapEndianess(T val) {
   return val;
 }
 
+// Convert word loaded from data to little endian value, so the kernels can
+// index lookup tables by byte position in data on any host.
+template <typename T>
+T FromLittleEndian(T val) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  return SwapEndianess(val);
+#else
+  return val;
+#endif
+}
+
+namespace detail {
+
+// Register types of the profile, indexed by ProfileType().
+constexpr const char* kProfileTypes[] = {"crc8", "crc16", "crc32", "crc64"};
+constexpr const char* kProfileOrderings[] = {"normal", "reflected"};
+
+constexpr size_t ProfileType(size_t register_size) noexcept {
+  return (register_size == 1)   ? 0
+         : (register_size == 2) ? 1
+         : (register_size == 4) ? 2
+                                : 3;
+}
+
+// Selections of every register type and data ordering listed in a profile.
+struct CrcProfile {
+  static constexpr size_t kTypes = std::size(kProfileTypes);
+  CrcChunks chunks[kTypes][2][kSizeClasses] = {};
+  bool present[kTypes][2] = {};
+};
+
+// Index of 'name' in 'names', or 'count' if there is none.
+inline size_t FindName(const std::string& name, const char* const* names,
+                       size_t count) noexcept {
+  size_t index = 0;
+  while (index < count && name != names[index]) {
+    ++index;
+  }
+  return index;
+}
+
+inline bool ParseCrcChunks(const std::string& name, CrcChunks* chunks) {
+  for (int method = BYTE_BY_BYTE; method < CHUNKS_AUTO; ++method) {
+    if (name == CrcChunksName(static_cast<CrcChunks>(method))) {
+      *chunks = static_cast<CrcChunks>(method);
+      return true;
+    }
+  }
+  return false;
+}
+
+inline bool ParseCrcProfile(const std::string& text, CrcProfile* profile) {
+  std::istringstream lines(text);
+  std::string line;
+  while (std::getline(lines, line)) {
+    std::istringstream fields(line);
+    std::string type_name;
+    if (!(fields >> type_name) || type_name[0] == '#') {
+      continue;
+    }
+    std::string ordering_name;
+    fields >> ordering_name;
+    const size_t type =
+        FindName(type_name, kProfileTypes, std::size(kProfileTypes));
+    const size_t ordering = FindName(ordering_name, kProfileOrderings,
+                                     std::size(kProfileOrderings));
+    if (type == std::size(kProfileTypes) ||
+        ordering == std::size(kProfileOrderings)) {
+      return false;
+    }
+    for (CrcChunks& chunks : profile->chunks[type][ordering]) {
+      std::string name;
+      if (!(fields >> name) || !ParseCrcChunks(name, &chunks)) {
+        return false;
+      }
+    }
+    std::string extra;
+    if (fields >> extra) {
+      return false;
+    }
+    profile->present[type][ordering] = true;
+  }
+  return true;
+}
+
+inline bool ReadFile(const std::string& path, std::string* contents) {
+  std::ifstream file(path);
+  if (!file) {
+    return false;
+  }
+  std::ostringstream stream;
+  stream << file.rdbuf();
+  *contents = stream.str();
+  return !file.bad();
+}
+
+// Profile given by the environment, read once per process.
+inline const CrcProfile& EnvironmentProfile() {
+  static const CrcProfile profile = [] {
+    CrcProfile result;
+    std::string text;
+    const char* path = std::getenv("HASHLIB_CRC_PROFILE");
+    if (path != nullptr &&
+        (!ReadFile(path, &text) || !ParseCrcProfile(text, &result))) {
+      result = CrcProfile();
+    }
+    CrcChunks pinned;
+    const char* method = std::getenv("HASHLIB_CRC_METHOD");
+    if (method != nullptr && ParseCrcChunks(method, &pinned)) {
+      for (auto& type : result.chunks) {
+        for (auto& ordering : type) {
+          std::fill(std::begin(ordering), std::end(ordering), pinned);
+        }
+      }
+      for (auto& type : result.present) {
+        std::fill(std::begin(type), std::end(type), true);
+      }
+    }
+    return result;
+  }();
+  return profile;
+}
+
+}  // namespace detail
+
 namespace {
 
 class Timer {
  public:
-  Timer() : start_(std::chrono::system_clock::now()) {}
+  Timer() : start_(std::chrono::steady_clock::now()) {}
   double elapsed() {
-    return std::chrono::duration<double>(std::chrono::system_clock::now() -
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
                                          start_)
         .count();
   }
 
  private:
-  std::chrono::system_clock::time_point start_;
+  std::chrono::steady_clock::time_point start_;
 };
 
 }  // namespace
 
 template <typename T>
-void Crc<T>::Optimize(uint64_t buffer_size, uint64_t repeats) {
-  double best_time = 1e16;
-  CrcChunks best_type = CHUNKS_4x32b;
-  // Delete later.
-  char* buffer = static_cast<char*>(std::malloc(buffer_size * sizeof(*buffer)));
-  Timer t;
-  for (size_t i = 0; i < repeats; ++i) {
-    Consume_1x32b(buffer, buffer_size);
-  }
-  double time = t.elapsed();
-  if (time < best_time) {
-    best_time = time;
-    best_type = CHUNKS_1x32b;
-  }
-  t = Timer();
-  for (size_t i = 0; i < repeats; ++i) {
-    Consume_2x32b(buffer, buffer_size);
-  }
-  time = t.elapsed();
-  if (time < best_time) {
-    best_time = time;
-    best_type = CHUNKS_2x32b;
-  }
-  t = Timer();
-  for (size_t i = 0; i < repeats; ++i) {
-    Consume_4x32b(buffer, buffer_size);
+CrcChunks CrcDispatcher<T>::Get(bool reverse_data, size_t size) noexcept {
+  return Selected(reverse_data, SizeClass(size))
+      .load(std::memory_order_relaxed);
+}
+
+template <typename T>
+CrcChunks CrcDispatcher<T>::Get(bool reverse_data) noexcept {
+  return Selected(reverse_data, kSizeClasses - 1)
+      .load(std::memory_order_relaxed);
+}
+
+template <typename T>
+size_t CrcDispatcher<T>::Slices(bool reverse_data) noexcept {
+  size_t slices = 1;
+  for (size_t size_class = 0; size_class < kSizeClasses; ++size_class) {
+    const CrcChunks chunks =
+        Selected(reverse_data, size_class).load(std::memory_order_relaxed);
+    slices = std::max(slices, TableSlices(chunks));
+  }
+  return slices;
+}
+
+template <typename T>
+void CrcDispatcher<T>::Calibrate(const Crc<T>& crc, bool reverse_data,
+                                 uint64_t bytes) {
+  // Representative message of every size class.
+  static constexpr size_t sizes[kSizeClasses] = {40, 256, 2 * 1024,
+                                                 16 * 1024, 256 * 1024};
+  static std::once_flag calibrated[2];
+  std::call_once(calibrated[reverse_data], [&] {
+    if (Fixed(reverse_data)) {
+      return;
+    }
+    CrcChunks measured[kSizeClasses];
+    for (size_t size_class = 0; size_class < kSizeClasses; ++size_class) {
+      measured[size_class] = Measure(crc, sizes[size_class], bytes);
+    }
+    // Keep the selection pinned during the measurement.
+    if (!Fixed(reverse_data)) {
+      Pin(reverse_data, measured);
+    }
+  });
+}
+
+template <typename T>
+void CrcDispatcher<T>::Pin(bool reverse_data,
+                           const CrcChunks (&chunks)[kSizeClasses]) noexcept {
+  for (size_t size_class = 0; size_class < kSizeClasses; ++size_class) {
+    Selected(reverse_data, size_class)
+        .store(chunks[size_class], std::memory_order_relaxed);
+  }
+  Selections().fixed[reverse_data].store(true, std::memory_order_relaxed);
+}
+
+template <typename T>
+bool CrcDispatcher<T>::Fixed(bool reverse_data) noexcept {
+  return Selections().fixed[reverse_data].load(std::memory_order_relaxed);
+}
+
+// Hardware folding is faster than any table based method. Without it, the
+// 32 slices of 64-bit values (64 kB) no longer fit in L1 cache.
+template <typename T>
+CrcChunks CrcDispatcher<T>::Detect() noexcept {
+  const hw::CpuFeatures& features = hw::GetCpuFeatures();
+  if (features.clmul) {
+    return HW_CLMUL;
+  }
+  return (sizeof(T) == sizeof(uint64_t)) ? CHUNKS_4x32b : CHUNKS_8x32b;
+}
+
+template <typename T>
+CrcChunks CrcDispatcher<T>::Measure(const Crc<T>& crc, size_t size,
+                                    uint64_t bytes) {
+  static constexpr CrcChunks candidates[] = {
+      BYTE_BY_BYTE, CHUNKS_1x32b, CHUNKS_2x32b, CHUNKS_4x32b, CHUNKS_8x32b,
+      CHUNKS_1x64b, CHUNKS_2x64b, CHUNKS_4x64b, HW_CLMUL};
+  const hw::CpuFeatures& features = hw::GetCpuFeatures();
+  const bool has_hw = features.clmul || features.crc32c || features.crc32;
+  const std::vector<uint8_t> buffer(size);
+  const uint64_t repeats = std::max<uint64_t>(1, bytes / size);
+  // Do not modify state of the provided instance.
+  Crc<T> probe(crc);
+  double best_time = 1e16;
+  CrcChunks best_type = Detect();
+  for (const CrcChunks chunks : candidates) {
+    if (chunks == HW_CLMUL && !has_hw) {
+      continue;
+    }
+    // Allocate the table outside of the measurement.
+    probe.Consume(buffer.data(), 0, chunks);
+    Timer t;
+    for (size_t i = 0; i < repeats; ++i) {
+      probe.Consume(buffer.data(), buffer.size(), chunks);
+    }
+    const double time = t.elapsed();
+    if (time < best_time) {
+      best_time = time;
+      best_type = chunks;
+    }
+  }
+  return best_type;
+}
+
+template <typename T>
+CrcDispatcher<T>::Selection::Selection() {
+  const detail::CrcProfile& profile = detail::EnvironmentProfile();
+  const size_t type = detail::ProfileType(sizeof(T));
+  for (size_t ordering = 0; ordering < 2; ++ordering) {
+    const bool present = profile.present[type][ordering];
+    for (size_t size_class = 0; size_class < kSizeClasses; ++size_class) {
+      chunks[ordering][size_class].store(
+          (present) ? profile.chunks[type][ordering][size_class] : Detect(),
+          std::memory_order_relaxed);
+    }
+    fixed[ordering].store(present, std::memory_order_relaxed);
+  }
+}
+
+template <typename T>
+typename CrcDispatcher<T>::Selection& CrcDispatcher<T>::Selections() noexcept {
+  static Selection selection;
+  return selection;
+}
+
+template <typename T>
+std::atomic<CrcChunks>& CrcDispatcher<T>::Selected(bool reverse_data,
+                                                   size_t size_class) noexcept {
+  return Selections().chunks[reverse_data][size_class];
+}
+
+namespace detail {
+
+// Append profile lines of both data orderings of CrcDispatcher<T>.
+template <typename T>
+void SaveDispatcherProfile(std::string* profile) {
+  for (const bool reverse_data : {false, true}) {
+    if (!CrcDispatcher<T>::Fixed(reverse_data)) {
+      continue;
+    }
+    *profile += kProfileTypes[ProfileType(sizeof(T))];
+    *profile += ' ';
+    *profile += kProfileOrderings[reverse_data];
+    for (const size_t limit : kSizeClassLimits) {
+      *profile += ' ';
+      *profile += CrcChunksName(CrcDispatcher<T>::Get(reverse_data, limit));
+    }
+    *profile += ' ';
+    *profile += CrcChunksName(CrcDispatcher<T>::Get(reverse_data));
+    *profile += '\n';
+  }
+}
+
+// Pin selections of CrcDispatcher<T> present in the profile.
+template <typename T>
+void LoadDispatcherProfile(const CrcProfile& profile) {
+  const size_t type = ProfileType(sizeof(T));
+  for (const bool reverse_data : {false, true}) {
+    if (profile.present[type][reverse_data]) {
+      CrcDispatcher<T>::Pin(reverse_data, profile.chunks[type][reverse_data]);
+    }
+  }
+}
+
+}  // namespace detail
+
+inline std::string SaveCrcProfile() {
+  std::string profile = "# type ordering method-per-size-class\n";
+  detail::SaveDispatcherProfile<uint8_t>(&profile);
+  detail::SaveDispatcherProfile<uint16_t>(&profile);
+  detail::SaveDispatcherProfile<uint32_t>(&profile);
+  detail::SaveDispatcherProfile<uint64_t>(&profile);
+  return profile;
+}
+
+inline bool LoadCrcProfile(const std::string& profile) {
+  detail::CrcProfile parsed;
+  if (!detail::ParseCrcProfile(profile, &parsed)) {
+    return false;
+  }
+  detail::LoadDispatcherProfile<uint8_t>(parsed);
+  detail::LoadDispatcherProfile<uint16_t>(parsed);
+  detail::LoadDispatcherProfile<uint32_t>(parsed);
+  detail::LoadDispatcherProfile<uint64_t>(parsed);
+  return true;
+}
+
+inline bool SaveCrcProfileFile(const std::string& path) {
+  std::ofstream file(path);
+  file << SaveCrcProfile();
+  file.close();
+  return !file.fail();
+}
+
+inline bool LoadCrcProfileFile(const std::string& path) {
+  std::string profile;
+  return detail::ReadFile(path, &profile) && LoadCrcProfile(profile);
+}
+
+inline const char* CrcChunksName(CrcChunks chunks) noexcept {
+  static constexpr const char* names[] = {
+      "BYTE_BY_BYTE", "CHUNKS_1x32b", "CHUNKS_2x32b", "CHUNKS_4x32b",
+      "CHUNKS_8x32b", "CHUNKS_1x64b", "CHUNKS_2x64b", "CHUNKS_4x64b",
+      "SIMD_GATHER",  "HW_CLMUL",     "CHUNKS_AUTO"};
+  static_assert(std::size(names) == CHUNKS_AUTO + 1,
+                "Every method needs a name.");
+  return (chunks <= CHUNKS_AUTO) ? names[chunks] : "?";
+}
+
+template <typename T>
+void Crc<T>::Optimize(uint64_t buffer_size, uint64_t repeats) {
+  CrcDispatcher<T>::Calibrate(*this, reverse_data_, buffer_size * repeats);
+  chunks_ = CHUNKS_AUTO;
+  // Switch to the table matching new methods, which may also be smaller.
+  table_ = detail::GetCrcTable(polynomial_, reverse_data_,
+                               CrcDispatcher<T>::Slices(reverse_data_));
+}
+
+template <typename T>
+void Crc<T>::ReserveTable(CrcChunks chunks) {
+  const size_t slices = (chunks == CHUNKS_AUTO)
+                            ? CrcDispatcher<T>::Slices(reverse_data_)
+                            : TableSlices(chunks);
+  if (table_ == nullptr || table_->slices < slices) {
+    table_ = detail::GetCrcTable(polynomial_, reverse_data_, slices);
+  }
+}
+
+template <typename T>
+void Crc<T>::ConsumeBytes(const uint8_t* data, size_t size,
+                          CrcChunks chunks) noexcept {
+#if HASHLIB_CRC_STATS
+  const uint64_t start = hw::ReadCycles();
+#endif
+  crc_ = Advance(*table_, crc_, data, size, chunks);
+#if HASHLIB_CRC_STATS
+  stats_.Record(chunks, size, hw::ReadCycles() - start);
+#endif
+}
+
+template <typename T>
+CrcChunks Crc<T>::Resolve(size_t size) const noexcept {
+  CrcChunks chunks = chunks_;
+  if (chunks == CHUNKS_AUTO) {
+    chunks = CrcDispatcher<T>::Get(reverse_data_, size);
+  }
+  return detail::FitTable(chunks, table_->slices);
+}
+
+template <typename T>
+T Crc<T>::Advance(const CrcTable<T>& table, T crc, const uint8_t* data,
+                  size_t size, CrcChunks chunks) const noexcept {
+  return (reverse_data_) ? detail::CrcKernels<T, true>::Consume(
+                               table, crc, data, size, chunks)
+                         : detail::CrcKernels<T, false>::Consume(
+                               table, crc, data, size, chunks);
+}
+
+template <typename T>
+T Crc<T>::Finalize(T crc) const noexcept {
+  return static_cast<T>(
+      detail::FinalCrc(crc, xor_output_, reverse_data_, reverse_out_) >>
+      out_shift_);
+}
+
+template <typename T>
+template <typename Y>
+void Crc<T>::Consume(const Y* data, size_t size) noexcept {
+  const size_t bytes = size * sizeof(Y);
+  // Cast provided data to match template type.
+  ConsumeBytes(reinterpret_cast<const uint8_t*>(data), bytes, Resolve(bytes));
+}
+
+template <typename T>
+template <typename Y>
+void Crc<T>::Consume(const Y* data, size_t size, CrcChunks chunks) {
+  const size_t bytes = size * sizeof(Y);
+  if (chunks == CHUNKS_AUTO) {
+    chunks = CrcDispatcher<T>::Get(reverse_data_, bytes);
+  }
+  ReserveTable(chunks);
+  ConsumeBytes(reinterpret_cast<const uint8_t*>(data), bytes, chunks);
+}
+
+template <typename T>
+void Crc<T>::Consume(const CrcBuffer* segments, size_t count) noexcept {
+  ConsumeChain(segments, count);
+}
+
+#if defined(HASHLIB_POSIX_IOVEC)
+template <typename T>
+void Crc<T>::Consume(const iovec* segments, size_t count) noexcept {
+  ConsumeChain(segments, count);
+}
+#endif
+
+template <typename T>
+template <typename Y>
+void Crc<T>::CopyAndConsume(Y* dst, const Y* src, size_t size) noexcept {
+  auto* dst_8 = reinterpret_cast<uint8_t*>(dst);
+  const auto* src_8 = reinterpret_cast<const uint8_t*>(src);
+  size *= sizeof(Y);
+  const bool streaming = size >= kStreamingCopyThreshold;
+  while (size > 0) {
+    const size_t tile = std::min(size, kCopyTileSize);
+    if (streaming) {
+      hw::CopyStreaming(dst_8, src_8, tile);
+    } else {
+      std::memcpy(dst_8, src_8, tile);
+    }
+    // Source was just read by the copy, streamed destination is not cached.
+    Consume(src_8, tile);
+    dst_8 += tile;
+    src_8 += tile;
+    size -= tile;
+  }
+}
+
+template <typename T>
+template <typename Segment>
+void Crc<T>::ConsumeChain(const Segment* segments, size_t count) noexcept {
+  // Short segments and ends of the long ones are gathered here, until there
+  // is a block long enough for the wide kernels.
+  alignas(64) uint8_t carry[kChainCarrySize];
+  size_t carried = 0;
+  for (size_t i = 0; i < count; ++i) {
+    const uint8_t* data = detail::SegmentData(segments[i]);
+    size_t size = detail::SegmentSize(segments[i]);
+    if (size == 0) {
+      continue;
+    }
+    if (carried > 0 || size < kChainCarrySize) {
+      const size_t fill = std::min(size, kChainCarrySize - carried);
+      std::memcpy(carry + carried, data, fill);
+      carried += fill;
+      data += fill;
+      size -= fill;
+      if (carried < kChainCarrySize) {
+        continue;
+      }
+      Consume(carry, carried);
+      carried = 0;
+    }
+    const size_t body = size - size % kChainWordSize;
+    if (body > 0) {
+      Consume(data, body);
+    }
+    carried = size - body;
+    std::memcpy(carry, data + body, carried);
   }
-  time = t.elapsed();
-  if (time < best_time) {
-    best_time = time;
-    best_type = CHUNKS_4x32b;
+  if (carried > 0) {
+    Consume(carry, carried);
   }
-  t = Timer();
-  for (size_t i = 0; i < repeats; ++i) {
-    Consume_8x32b(buffer, buffer_size);
+}
+
+template <typename T>
+template <typename Y, typename Pool>
+void Crc<T>::ConsumeParallel(const Y* data, size_t size, Pool& pool,
+                             size_t threshold) {
+  const auto* casted_data_8 = reinterpret_cast<const uint8_t*>(data);
+  const size_t bytes = size * sizeof(Y);
+  const size_t parts =
+      std::min<size_t>(pool.size() + 1, bytes / kMinParallelChunk);
+  if (bytes < threshold || parts < 2) {
+    Consume(casted_data_8, bytes);
+    return;
   }
-  time = t.elapsed();
-  if (time < best_time) {
-    best_time = time;
-    best_type = CHUNKS_8x32b;
+  CrcChunks chunks = chunks_;
+  if (chunks == CHUNKS_AUTO) {
+    chunks = CrcDispatcher<T>::Get(reverse_data_);
   }
-  t = Timer();
-  for (size_t i = 0; i < repeats; ++i) {
-    Consume_byte_by_byte(buffer, buffer_size);
+  // Tasks only read the table, so it has to be ready before they start.
+  ReserveTable(chunks);
+#if HASHLIB_CRC_STATS
+  const uint64_t start = hw::ReadCycles();
+#endif
+  const CrcTable<T>* table = table_;
+  const auto kernel = (reverse_data_) ? &detail::CrcKernels<T, true>::Consume
+                                      : &detail::CrcKernels<T, false>::Consume;
+  // Keep chunks 64 byte aligned relative to each other, for hardware folding.
+  const size_t part_size = (bytes / parts) & ~static_cast<size_t>(63);
+  const size_t last_size = bytes - part_size * (parts - 1);
+
+  // Every part starts with an empty register. Register after consuming the
+  // part is a linear function of the initial register.
+  const auto submit = [&](const uint8_t* part) {
+    return pool.Submit(
+        [=] { return kernel(*table, 0, part, part_size, chunks); });
+  };
+  std::vector<decltype(submit(casted_data_8))> results;
+  results.reserve(parts - 1);
+  try {
+    for (size_t i = 0; i < parts - 1; ++i) {
+      results.push_back(submit(casted_data_8 + i * part_size));
+    }
+  } catch (...) {
+    // Submitted parts still read 'data', wait for them before unwinding.
+    for (auto& result : results) {
+      result.wait();
+    }
+    throw;
   }
-  time = t.elapsed();
-  if (time < best_time) {
-    best_type = BYTE_BY_BYTE;
+  const T last = kernel(*table, 0, casted_data_8 + bytes - last_size,
+                        last_size, chunks);
+
+  const T part_shift = detail::XPowMod(polynomial_, 8 * part_size);
+  const T last_shift = detail::XPowMod(polynomial_, 8 * last_size);
+  for (auto& result : results) {
+    crc_ = detail::ShiftRegister(crc_, part_shift, polynomial_, reverse_data_) ^
+           result.get();
   }
-  reset();
-  chunks_ = best_type;
-  delete buffer;
+  crc_ = detail::ShiftRegister(crc_, last_shift, polynomial_, reverse_data_) ^
+         last;
+#if HASHLIB_CRC_STATS
+  stats_.Record(chunks, bytes, hw::ReadCycles() - start);
+#endif
 }
 
 template <typename T>
-template <typename Y>
-void Crc<T>::Consume(const Y* data, size_t size) {
-  Consume(data, size, chunks_);
+void Crc<T>::ChecksumBatch(const CrcBuffer* buffers, size_t count,
+                           T* results) const {
+  BatchRegisters(buffers, count, results);
+  for (size_t i = 0; i < count; ++i) {
+    const T value =
+        detail::FinalCrc(results[i], xor_output_, reverse_data_, reverse_out_);
+    results[i] = static_cast<T>(value >> out_shift_);
+  }
 }
 
 template <typename T>
-template <typename Y>
-void Crc<T>::Consume(const Y* data, size_t size, CrcChunks chunks_) {
-  switch (chunks_) {
-    case CHUNKS_8x32b:
-      return Consume_8x32b(data, size);
-    case CHUNKS_4x32b:
-      return Consume_4x32b(data, size);
-    case CHUNKS_2x32b:
-      return Consume_2x32b(data, size);
-    case CHUNKS_1x32b:
-      return Consume_1x32b(data, size);
-    case BYTE_BY_BYTE:
-      return Consume_byte_by_byte(data, size);
+size_t Crc<T>::VerifyBlocks(const void* data, size_t block_size,
+                            const T* expected, size_t count) const {
+  const auto* blocks = static_cast<const uint8_t*>(data);
+  // Expected values are transformed to registers, so the computed registers
+  // are compared as they are, without the output transformation.
+  const bool reverse = reverse_data_ ^ reverse_out_;
+  CrcBuffer buffers[kVerifyBatchSize];
+  T registers[kVerifyBatchSize];
+  for (size_t first = 0; first < count; first += kVerifyBatchSize) {
+    const size_t batch = std::min(count - first, kVerifyBatchSize);
+    for (size_t i = 0; i < batch; ++i) {
+      buffers[i] = {blocks + (first + i) * block_size, block_size};
+    }
+    BatchRegisters(buffers, batch, registers);
+    for (size_t i = 0; i < batch; ++i) {
+      const auto aligned = static_cast<T>(expected[first + i] << out_shift_);
+      T value = aligned ^ xor_output_;
+      if (reverse) {
+        value = detail::ReverseBits(value);
+      }
+      if (registers[i] != value) {
+        return first + i;
+      }
+    }
   }
+  return count;
 }
 
 template <typename T>
-template <typename Y>
-void Crc<T>::Consume_byte_by_byte(const Y* data, size_t size) {
-  // Cast provided data to match template type.
-  const auto* casted_data_8 = reinterpret_cast<const uint8_t*>(data);
-  const size_t bytes_left = size * sizeof(Y);
+void Crc<T>::BatchRegisters(const CrcBuffer* buffers, size_t count,
+                            T* registers) const {
+  CrcChunks chunks = chunks_;
+  if (chunks == CHUNKS_AUTO) {
+    chunks = CrcDispatcher<T>::Get(reverse_data_);
+  }
+  // Lanes use 8 slices, remaining bytes are consumed with selected method.
+  const size_t slices = std::max<size_t>(TableSlices(chunks), 8);
+  const CrcTable<T>* table =
+      (table_->slices >= slices)
+          ? table_
+          : detail::GetCrcTable(polynomial_, reverse_data_, slices);
+  const T initial = detail::InitialRegister(initial_crc_, reverse_data_);
   if (reverse_data_) {
-    crc_ = std::accumulate(casted_data_8, casted_data_8 + bytes_left, crc_,
-                           [&](T crc, uint8_t value) {
-                             return (crc >> 8) ^
-                                    lookup_table_[0][(crc ^ value) & 0xFF];
-                           });
+    detail::CrcKernels<T, true>::ConsumeBatch(*table, initial, buffers, count,
+                                              chunks, registers);
+  } else {
+    detail::CrcKernels<T, false>::ConsumeBatch(*table, initial, buffers,
+                                               count, chunks, registers);
+  }
+}
+
+template <typename T>
+template <size_t N>
+std::array<T, N> Crc<T>::ChecksumBatch(
+    const std::array<CrcBuffer, N>& buffers) const {
+  std::array<T, N> results;
+  ChecksumBatch(buffers.data(), N, results.data());
+  return results;
+}
+
+namespace detail {
+
+template <typename T, bool reflected>
+T CrcKernels<T, reflected>::Consume_byte_by_byte(const CrcTable<T>& table,
+                                                T crc, const uint8_t* data,
+                                                size_t size) {
+  // Unrolled by 4 bytes. Every byte still depends on the previous one, but
+  // the loop overhead is paid once per word.
+  const T* lookup = table.lookup[0];
+  if constexpr (reflected) {
+    for (; size >= 4; size -= 4, data += 4) {
+      crc = (crc >> 8) ^ lookup[(crc ^ data[0]) & 0xFF];
+      crc = (crc >> 8) ^ lookup[(crc ^ data[1]) & 0xFF];
+      crc = (crc >> 8) ^ lookup[(crc ^ data[2]) & 0xFF];
+      crc = (crc >> 8) ^ lookup[(crc ^ data[3]) & 0xFF];
+    }
+    for (; size > 0; --size, ++data) {
+      crc = (crc >> 8) ^ lookup[(crc ^ *data) & 0xFF];
+    }
   } else {
     static constexpr uint32_t shift = (sizeof(T) * 8) - 8;
-    crc_ = std::accumulate(
-        casted_data_8, casted_data_8 + bytes_left, crc_,
-        [&](T crc, uint8_t value) {
-          return (crc << 8) ^ lookup_table_[0][((crc >> shift) ^ value) & 0xFF];
-        });
+    for (; size >= 4; size -= 4, data += 4) {
+      crc = static_cast<T>(crc << 8) ^
+            lookup[((crc >> shift) ^ data[0]) & 0xFF];
+      crc = static_cast<T>(crc << 8) ^
+            lookup[((crc >> shift) ^ data[1]) & 0xFF];
+      crc = static_cast<T>(crc << 8) ^
+            lookup[((crc >> shift) ^ data[2]) & 0xFF];
+      crc = static_cast<T>(crc << 8) ^
+            lookup[((crc >> shift) ^ data[3]) & 0xFF];
+    }
+    for (; size > 0; --size, ++data) {
+      crc = static_cast<T>(crc << 8) ^
+            lookup[((crc >> shift) ^ *data) & 0xFF];
+    }
+  }
+  return crc;
+}
+
+template <typename T, bool reflected>
+T CrcKernels<T, reflected>::Step_1x32b(const CrcTable<T>& table, T crc,
+                                       uint32_t word) {
+  // Part of the register wider than the word is shifted away from the data.
+  T rest = 0;
+  if constexpr (reflected) {
+    word ^= static_cast<uint32_t>(crc);
+    if constexpr (sizeof(T) > sizeof(uint32_t)) {
+      rest = crc >> 32;
+    }
+  } else {
+    word ^= static_cast<uint32_t>(SwapEndianess(crc));
+    if constexpr (sizeof(T) > sizeof(uint32_t)) {
+      rest = crc << 32;
+    }
+  }
+  return rest ^ table.lookup[0][(word >> 24) & 0xFF] ^
+         table.lookup[1][(word >> 16) & 0xFF] ^
+         table.lookup[2][(word >> 8) & 0xFF] ^ table.lookup[3][word & 0xFF];
+}
+
+template <typename T, bool reflected>
+T CrcKernels<T, reflected>::ConsumeHead(const CrcTable<T>& table, T crc,
+                                        const uint8_t** data, size_t* size,
+                                        size_t alignment) {
+  // Aligned loads are faster and required on strict alignment targets.
+  const size_t misalignment =
+      (alignment - reinterpret_cast<uintptr_t>(*data) % alignment) % alignment;
+  const size_t head = std::min(misalignment, *size);
+  crc = Consume_byte_by_byte(table, crc, *data, head);
+  *data += head;
+  *size -= head;
+  return crc;
+}
+
+template <typename T, bool reflected>
+T CrcKernels<T, reflected>::ConsumeTail(const CrcTable<T>& table, T crc,
+                                        const uint8_t* data, size_t size) {
+  // Data is already aligned by ConsumeHead().
+  const auto* casted_data_32 = reinterpret_cast<const uint32_t*>(data);
+  for (; size >= sizeof(uint32_t); size -= sizeof(uint32_t)) {
+    crc = Step_1x32b(table, crc, FromLittleEndian(*casted_data_32++));
   }
+  return Consume_byte_by_byte(
+      table, crc, reinterpret_cast<const uint8_t*>(casted_data_32), size);
 }
 
 // Notes:
 // To obtain maximum performance code duplication was required. Adding any kind
 // of generalized function to handle specific number of 32b words result in
 // significant performance decrease.
-// 1. Adding 'crc_ ^= ' after every 2 words provide significant increase in
+// 1. Adding 'crc ^= ' after every 2 words provide significant increase in
 // performance with MVSC compiler.
 // 2. Switching from data++ to ++data porvided slight increase in performance.
 // 2.1 Require uglu --data before processing.
 // 3. Unrolling for. With optimizations turned on provide much faster code.
-template <typename T>
-template <typename Y>
-void Crc<T>::Consume_1x32b(const Y* data, size_t size) {
+template <typename T, bool reflected>
+T CrcKernels<T, reflected>::Consume_1x32b(const CrcTable<T>& table, T crc,
+                                          const uint8_t* data, size_t size) {
+  crc = ConsumeHead(table, crc, &data, &size);
   // Cast provided data to match template type.
   const auto* casted_data_32 = reinterpret_cast<const uint32_t*>(data);
-  size_t bytes_left = size * sizeof(Y);
+  size_t bytes_left = size;
   static constexpr uint8_t unroll = 16;
   static constexpr uint32_t bytes_at_once = sizeof(uint32_t) * unroll;
   --casted_data_32;
-  if (reverse_data_) {
-    while (bytes_left >= bytes_at_once) {
-      for (size_t i = 0; i < unroll; ++i) {
-        const uint32_t word_1 = *++casted_data_32 ^ static_cast<uint32_t>(crc_);
-        crc_ = lookup_table_[0][(word_1 >> 24) & 0xFF] ^
-               lookup_table_[1][(word_1 >> 16) & 0xFF] ^
-               lookup_table_[2][(word_1 >> 8) & 0xFF] ^
-               lookup_table_[3][word_1 & 0xFF];
-      }
-      bytes_left -= bytes_at_once;
-    }
-  } else {
-    while (bytes_left >= bytes_at_once) {
-      for (size_t i = 0; i < unroll; ++i) {
-        const uint32_t word_1 =
-            *++casted_data_32 ^ static_cast<uint32_t>(SwapEndianess(crc_));
-        crc_ = lookup_table_[0][(word_1 >> 24) & 0xFF] ^
-               lookup_table_[1][(word_1 >> 16) & 0xFF] ^
-               lookup_table_[2][(word_1 >> 8) & 0xFF] ^
-               lookup_table_[3][word_1 & 0xFF];
-      }
-      bytes_left -= bytes_at_once;
+  while (bytes_left >= bytes_at_once) {
+    for (size_t i = 0; i < unroll; ++i) {
+      crc = Step_1x32b(table, crc, FromLittleEndian(*++casted_data_32));
     }
+    bytes_left -= bytes_at_once;
   }
-  // Consume last bytes if any.
-  const auto* casted_data_8 =
-      reinterpret_cast<const uint8_t*>(++casted_data_32);
-  Consume_byte_by_byte(casted_data_8, bytes_left);
+  // Consume last words and bytes if any.
+  return ConsumeTail(table, crc,
+                     reinterpret_cast<const uint8_t*>(++casted_data_32),
+                     bytes_left);
 }
 
-template <typename T>
-template <typename Y>
-void Crc<T>::Consume_2x32b(const Y* data, size_t size) {
+template <typename T, bool reflected>
+T CrcKernels<T, reflected>::Consume_2x32b(const CrcTable<T>& table, T crc,
+                                          const uint8_t* data, size_t size) {
+  crc = ConsumeHead(table, crc, &data, &size);
   // Cast provided data to match template type.
   const auto* casted_data_32 = reinterpret_cast<const uint32_t*>(data);
-  size_t bytes_left = size * sizeof(Y);
+  size_t bytes_left = size;
   static constexpr uint8_t unroll = 8;
   static constexpr uint32_t bytes_at_once = sizeof(uint32_t) * 2 * unroll;
   --casted_data_32;
-  if (reverse_data_) {
+  if constexpr (reflected) {
     while (bytes_left >= bytes_at_once) {
       for (size_t i = 0; i < unroll; ++i) {
-        const uint32_t word_1 = *++casted_data_32 ^ static_cast<uint32_t>(crc_);
+        const uint32_t word_1 =
+            FromLittleEndian(*++casted_data_32) ^ static_cast<uint32_t>(crc);
         const uint32_t word_2 =
-            *++casted_data_32 ^
-            static_cast<uint32_t>(static_cast<uint64_t>(crc_) >> 32);
-
-        crc_ = lookup_table_[0][(word_2 >> 24) & 0xFF] ^
-               lookup_table_[1][(word_2 >> 16) & 0xFF] ^
-               lookup_table_[2][(word_2 >> 8) & 0xFF] ^
-               lookup_table_[3][word_2 & 0xFF] ^
-               lookup_table_[4][(word_1 >> 24) & 0xFF] ^
-               lookup_table_[5][(word_1 >> 16) & 0xFF] ^
-               lookup_table_[6][(word_1 >> 8) & 0xFF] ^
-               lookup_table_[7][word_1 & 0xFF];
+            FromLittleEndian(*++casted_data_32) ^
+            static_cast<uint32_t>(static_cast<uint64_t>(crc) >> 32);
+
+        crc = table.lookup[0][(word_2 >> 24) & 0xFF] ^
+               table.lookup[1][(word_2 >> 16) & 0xFF] ^
+               table.lookup[2][(word_2 >> 8) & 0xFF] ^
+               table.lookup[3][word_2 & 0xFF] ^
+               table.lookup[4][(word_1 >> 24) & 0xFF] ^
+               table.lookup[5][(word_1 >> 16) & 0xFF] ^
+               table.lookup[6][(word_1 >> 8) & 0xFF] ^
+               table.lookup[7][word_1 & 0xFF];
       }
       bytes_left -= bytes_at_once;
     }
   } else {
     while (bytes_left >= bytes_at_once) {
       for (size_t i = 0; i < unroll; ++i) {
-        const T swapped = SwapEndianess(crc_);
-        const uint32_t word_1 =
-            *++casted_data_32 ^ static_cast<uint32_t>(swapped);
+        const T swapped = SwapEndianess(crc);
+        const uint32_t word_1 = FromLittleEndian(*++casted_data_32) ^
+                                static_cast<uint32_t>(swapped);
         const uint32_t word_2 =
-            *++casted_data_32 ^
+            FromLittleEndian(*++casted_data_32) ^
             static_cast<uint32_t>(static_cast<uint64_t>(swapped) >> 32);
 
-        crc_ = lookup_table_[0][(word_2 >> 24) & 0xFF] ^
-               lookup_table_[1][(word_2 >> 16) & 0xFF] ^
-               lookup_table_[2][(word_2 >> 8) & 0xFF] ^
-               lookup_table_[3][word_2 & 0xFF] ^
-               lookup_table_[4][(word_1 >> 24) & 0xFF] ^
-               lookup_table_[5][(word_1 >> 16) & 0xFF] ^
-               lookup_table_[6][(word_1 >> 8) & 0xFF] ^
-               lookup_table_[7][word_1 & 0xFF];
+        crc = table.lookup[0][(word_2 >> 24) & 0xFF] ^
+               table.lookup[1][(word_2 >> 16) & 0xFF] ^
+               table.lookup[2][(word_2 >> 8) & 0xFF] ^
+               table.lookup[3][word_2 & 0xFF] ^
+               table.lookup[4][(word_1 >> 24) & 0xFF] ^
+               table.lookup[5][(word_1 >> 16) & 0xFF] ^
+               table.lookup[6][(word_1 >> 8) & 0xFF] ^
+               table.lookup[7][word_1 & 0xFF];
       }
       bytes_left -= bytes_at_once;
     }
   }
-  // Consume last bytes if any.
-  const auto* casted_data_8 =
-      reinterpret_cast<const uint8_t*>(++casted_data_32);
-  Consume_byte_by_byte(casted_data_8, bytes_left);
+  // Consume last words and bytes if any.
+  return ConsumeTail(table, crc,
+                     reinterpret_cast<const uint8_t*>(++casted_data_32),
+                     bytes_left);
 }
 
-template <typename T>
-template <typename Y>
-void Crc<T>::Consume_4x32b(const Y* data, size_t size) {
+template <typename T, bool reflected>
+T CrcKernels<T, reflected>::Consume_4x32b(const CrcTable<T>& table, T crc,
+                                          const uint8_t* data, size_t size) {
+  crc = ConsumeHead(table, crc, &data, &size);
   // Cast provided data to match template type.
   const auto* casted_data_32 = reinterpret_cast<const uint32_t*>(data);
-  size_t bytes_left = size * sizeof(Y);
+  size_t bytes_left = size;
   static constexpr uint8_t unroll = 4;
   static constexpr uint32_t bytes_at_once = sizeof(uint32_t) * 4 * unroll;
   --casted_data_32;
-  if (reverse_data_) {
+  if constexpr (reflected) {
     while (bytes_left >= bytes_at_once) {
       for (size_t i = 0; i < unroll; ++i) {
-        const uint32_t word_1 = *++casted_data_32 ^ static_cast<uint32_t>(crc_);
+        const uint32_t word_1 =
+            FromLittleEndian(*++casted_data_32) ^ static_cast<uint32_t>(crc);
         const uint32_t word_2 =
-            *++casted_data_32 ^
-            static_cast<uint32_t>(static_cast<uint64_t>(crc_) >> 32);
-        const uint32_t word_3 = *++casted_data_32;
-        const uint32_t word_4 = *++casted_data_32;
-
-        crc_ = lookup_table_[0][(word_4 >> 24) & 0xFF] ^
-               lookup_table_[1][(word_4 >> 16) & 0xFF] ^
-               lookup_table_[2][(word_4 >> 8) & 0xFF] ^
-               lookup_table_[3][word_4 & 0xFF] ^
-               lookup_table_[4][(word_3 >> 24) & 0xFF] ^
-               lookup_table_[5][(word_3 >> 16) & 0xFF] ^
-               lookup_table_[6][(word_3 >> 8) & 0xFF] ^
-               lookup_table_[7][word_3 & 0xFF];
-        crc_ ^= lookup_table_[8][(word_2 >> 24) & 0xFF] ^
-                lookup_table_[9][(word_2 >> 16) & 0xFF] ^
-                lookup_table_[10][(word_2 >> 8) & 0xFF] ^
-                lookup_table_[11][word_2 & 0xFF] ^
-                lookup_table_[12][(word_1 >> 24) & 0xFF] ^
-                lookup_table_[13][(word_1 >> 16) & 0xFF] ^
-                lookup_table_[14][(word_1 >> 8) & 0xFF] ^
-                lookup_table_[15][word_1 & 0xFF];
+            FromLittleEndian(*++casted_data_32) ^
+            static_cast<uint32_t>(static_cast<uint64_t>(crc) >> 32);
+        const uint32_t word_3 = FromLittleEndian(*++casted_data_32);
+        const uint32_t word_4 = FromLittleEndian(*++casted_data_32);
+
+        crc = table.lookup[0][(word_4 >> 24) & 0xFF] ^
+               table.lookup[1][(word_4 >> 16) & 0xFF] ^
+               table.lookup[2][(word_4 >> 8) & 0xFF] ^
+               table.lookup[3][word_4 & 0xFF] ^
+               table.lookup[4][(word_3 >> 24) & 0xFF] ^
+               table.lookup[5][(word_3 >> 16) & 0xFF] ^
+               table.lookup[6][(word_3 >> 8) & 0xFF] ^
+               table.lookup[7][word_3 & 0xFF];
+        crc ^= table.lookup[8][(word_2 >> 24) & 0xFF] ^
+                table.lookup[9][(word_2 >> 16) & 0xFF] ^
+                table.lookup[10][(word_2 >> 8) & 0xFF] ^
+                table.lookup[11][word_2 & 0xFF] ^
+                table.lookup[12][(word_1 >> 24) & 0xFF] ^
+                table.lookup[13][(word_1 >> 16) & 0xFF] ^
+                table.lookup[14][(word_1 >> 8) & 0xFF] ^
+                table.lookup[15][word_1 & 0xFF];
       }
       bytes_left -= bytes_at_once;
     }
   } else {
     while (bytes_left >= bytes_at_once) {
       for (size_t i = 0; i < unroll; ++i) {
-        const T swapped = SwapEndianess(crc_);
-        const uint32_t word_1 =
-            *++casted_data_32 ^ static_cast<uint32_t>(swapped);
+        const T swapped = SwapEndianess(crc);
+        const uint32_t word_1 = FromLittleEndian(*++casted_data_32) ^
+                                static_cast<uint32_t>(swapped);
         const uint32_t word_2 =
-            *++casted_data_32 ^
+            FromLittleEndian(*++casted_data_32) ^
             static_cast<uint32_t>(static_cast<uint64_t>(swapped) >> 32);
-        const uint32_t word_3 = *++casted_data_32;
-        const uint32_t word_4 = *++casted_data_32;
-
-        crc_ = lookup_table_[0][(word_4 >> 24) & 0xFF] ^
-               lookup_table_[1][(word_4 >> 16) & 0xFF] ^
-               lookup_table_[2][(word_4 >> 8) & 0xFF] ^
-               lookup_table_[3][word_4 & 0xFF] ^
-               lookup_table_[4][(word_3 >> 24) & 0xFF] ^
-               lookup_table_[5][(word_3 >> 16) & 0xFF] ^
-               lookup_table_[6][(word_3 >> 8) & 0xFF] ^
-               lookup_table_[7][word_3 & 0xFF];
-        crc_ ^= lookup_table_[8][(word_2 >> 24) & 0xFF] ^
-                lookup_table_[9][(word_2 >> 16) & 0xFF] ^
-                lookup_table_[10][(word_2 >> 8) & 0xFF] ^
-                lookup_table_[11][word_2 & 0xFF] ^
-                lookup_table_[12][(word_1 >> 24) & 0xFF] ^
-                lookup_table_[13][(word_1 >> 16) & 0xFF] ^
-                lookup_table_[14][(word_1 >> 8) & 0xFF] ^
-                lookup_table_[15][word_1 & 0xFF];
+        const uint32_t word_3 = FromLittleEndian(*++casted_data_32);
+        const uint32_t word_4 = FromLittleEndian(*++casted_data_32);
+
+        crc = table.lookup[0][(word_4 >> 24) & 0xFF] ^
+               table.lookup[1][(word_4 >> 16) & 0xFF] ^
+               table.lookup[2][(word_4 >> 8) & 0xFF] ^
+               table.lookup[3][word_4 & 0xFF] ^
+               table.lookup[4][(word_3 >> 24) & 0xFF] ^
+               table.lookup[5][(word_3 >> 16) & 0xFF] ^
+               table.lookup[6][(word_3 >> 8) & 0xFF] ^
+               table.lookup[7][word_3 & 0xFF];
+        crc ^= table.lookup[8][(word_2 >> 24) & 0xFF] ^
+                table.lookup[9][(word_2 >> 16) & 0xFF] ^
+                table.lookup[10][(word_2 >> 8) & 0xFF] ^
+                table.lookup[11][word_2 & 0xFF] ^
+                table.lookup[12][(word_1 >> 24) & 0xFF] ^
+                table.lookup[13][(word_1 >> 16) & 0xFF] ^
+                table.lookup[14][(word_1 >> 8) & 0xFF] ^
+                table.lookup[15][word_1 & 0xFF];
       }
       bytes_left -= bytes_at_once;
     }
   }
-  // Consume last bytes if any.
-  const auto* casted_data_8 =
-      reinterpret_cast<const uint8_t*>(++casted_data_32);
-  Consume_byte_by_byte(casted_data_8, bytes_left);
+  // Consume last words and bytes if any.
+  return ConsumeTail(table, crc,
+                     reinterpret_cast<const uint8_t*>(++casted_data_32),
+                     bytes_left);
 }
 
-template <typename T>
-template <typename Y>
-void Crc<T>::Consume_8x32b(const Y* data, size_t size) {
+template <typename T, bool reflected>
+T CrcKernels<T, reflected>::Consume_8x32b(const CrcTable<T>& table, T crc,
+                                          const uint8_t* data, size_t size) {
+  crc = ConsumeHead(table, crc, &data, &size);
   // Cast provided data to match template type.
   const auto* casted_data_32 = reinterpret_cast<const uint32_t*>(data);
-  size_t bytes_left = size * sizeof(Y);
+  size_t bytes_left = size;
   static constexpr uint8_t unroll = 2;
   static constexpr uint32_t bytes_at_once = sizeof(uint32_t) * 8 * unroll;
   --casted_data_32;
-  if (reverse_data_) {
+  if constexpr (reflected) {
     while (bytes_left >= bytes_at_once) {
       for (size_t i = 0; i < unroll; ++i) {
-        const uint32_t word_1 = *++casted_data_32 ^ static_cast<uint32_t>(crc_);
+        const uint32_t word_1 =
+            FromLittleEndian(*++casted_data_32) ^ static_cast<uint32_t>(crc);
         const uint32_t word_2 =
-            *++casted_data_32 ^
-            static_cast<uint32_t>(static_cast<uint64_t>(crc_) >> 32);
-        const uint32_t word_3 = *++casted_data_32;
-        const uint32_t word_4 = *++casted_data_32;
-        const uint32_t word_5 = *++casted_data_32;
-        const uint32_t word_6 = *++casted_data_32;
-        const uint32_t word_7 = *++casted_data_32;
-        const uint32_t word_8 = *++casted_data_32;
-        crc_ = lookup_table_[0][(word_8 >> 24) & 0xFF] ^
-               lookup_table_[1][(word_8 >> 16) & 0xFF] ^
-               lookup_table_[2][(word_8 >> 8) & 0xFF] ^
-               lookup_table_[3][(word_8)&0xFF] ^
-               lookup_table_[4][(word_7 >> 24) & 0xFF] ^
-               lookup_table_[5][(word_7 >> 16) & 0xFF] ^
-               lookup_table_[6][(word_7 >> 8) & 0xFF] ^
-               lookup_table_[7][word_7 & 0xFF];
-        crc_ ^= lookup_table_[8][(word_6 >> 24) & 0xFF] ^
-                lookup_table_[9][(word_6 >> 16) & 0xFF] ^
-                lookup_table_[10][(word_6 >> 8) & 0xFF] ^
-                lookup_table_[11][(word_6)&0xFF] ^
-                lookup_table_[12][(word_5 >> 24) & 0xFF] ^
-                lookup_table_[13][(word_5 >> 16) & 0xFF] ^
-                lookup_table_[14][(word_5 >> 8) & 0xFF] ^
-                lookup_table_[15][word_5 & 0xFF];
-        crc_ ^= lookup_table_[16][(word_4 >> 24) & 0xFF] ^
-                lookup_table_[17][(word_4 >> 16) & 0xFF] ^
-                lookup_table_[18][(word_4 >> 8) & 0xFF] ^
-                lookup_table_[19][(word_4)&0xFF] ^
-                lookup_table_[20][(word_3 >> 24) & 0xFF] ^
-                lookup_table_[21][(word_3 >> 16) & 0xFF] ^
-                lookup_table_[22][(word_3 >> 8) & 0xFF] ^
-                lookup_table_[23][word_3 & 0xFF];
-        crc_ ^= lookup_table_[24][(word_2 >> 24) & 0xFF] ^
-                lookup_table_[25][(word_2 >> 16) & 0xFF] ^
-                lookup_table_[26][(word_2 >> 8) & 0xFF] ^
-                lookup_table_[27][(word_2)&0xFF] ^
-                lookup_table_[28][(word_1 >> 24) & 0xFF] ^
-                lookup_table_[29][(word_1 >> 16) & 0xFF] ^
-                lookup_table_[30][(word_1 >> 8) & 0xFF] ^
-                lookup_table_[31][word_1 & 0xFF];
+            FromLittleEndian(*++casted_data_32) ^
+            static_cast<uint32_t>(static_cast<uint64_t>(crc) >> 32);
+        const uint32_t word_3 = FromLittleEndian(*++casted_data_32);
+        const uint32_t word_4 = FromLittleEndian(*++casted_data_32);
+        const uint32_t word_5 = FromLittleEndian(*++casted_data_32);
+        const uint32_t word_6 = FromLittleEndian(*++casted_data_32);
+        const uint32_t word_7 = FromLittleEndian(*++casted_data_32);
+        const uint32_t word_8 = FromLittleEndian(*++casted_data_32);
+        crc = table.lookup[0][(word_8 >> 24) & 0xFF] ^
+               table.lookup[1][(word_8 >> 16) & 0xFF] ^
+               table.lookup[2][(word_8 >> 8) & 0xFF] ^
+               table.lookup[3][(word_8)&0xFF] ^
+               table.lookup[4][(word_7 >> 24) & 0xFF] ^
+               table.lookup[5][(word_7 >> 16) & 0xFF] ^
+               table.lookup[6][(word_7 >> 8) & 0xFF] ^
+               table.lookup[7][word_7 & 0xFF];
+        crc ^= table.lookup[8][(word_6 >> 24) & 0xFF] ^
+                table.lookup[9][(word_6 >> 16) & 0xFF] ^
+                table.lookup[10][(word_6 >> 8) & 0xFF] ^
+                table.lookup[11][(word_6)&0xFF] ^
+                table.lookup[12][(word_5 >> 24) & 0xFF] ^
+                table.lookup[13][(word_5 >> 16) & 0xFF] ^
+                table.lookup[14][(word_5 >> 8) & 0xFF] ^
+                table.lookup[15][word_5 & 0xFF];
+        crc ^= table.lookup[16][(word_4 >> 24) & 0xFF] ^
+                table.lookup[17][(word_4 >> 16) & 0xFF] ^
+                table.lookup[18][(word_4 >> 8) & 0xFF] ^
+                table.lookup[19][(word_4)&0xFF] ^
+                table.lookup[20][(word_3 >> 24) & 0xFF] ^
+                table.lookup[21][(word_3 >> 16) & 0xFF] ^
+                table.lookup[22][(word_3 >> 8) & 0xFF] ^
+                table.lookup[23][word_3 & 0xFF];
+        crc ^= table.lookup[24][(word_2 >> 24) & 0xFF] ^
+                table.lookup[25][(word_2 >> 16) & 0xFF] ^
+                table.lookup[26][(word_2 >> 8) & 0xFF] ^
+                table.lookup[27][(word_2)&0xFF] ^
+                table.lookup[28][(word_1 >> 24) & 0xFF] ^
+                table.lookup[29][(word_1 >> 16) & 0xFF] ^
+                table.lookup[30][(word_1 >> 8) & 0xFF] ^
+                table.lookup[31][word_1 & 0xFF];
       }
       bytes_left -= bytes_at_once;
     }
   } else {
     while (bytes_left >= bytes_at_once) {
       for (size_t i = 0; i < unroll; ++i) {
-        const T swapped = SwapEndianess(crc_);
-        const uint32_t word_1 =
-            *++casted_data_32 ^ static_cast<uint32_t>(swapped);
+        const T swapped = SwapEndianess(crc);
+        const uint32_t word_1 = FromLittleEndian(*++casted_data_32) ^
+                                static_cast<uint32_t>(swapped);
         const uint32_t word_2 =
-            *++casted_data_32 ^
+            FromLittleEndian(*++casted_data_32) ^
             static_cast<uint32_t>(static_cast<uint64_t>(swapped) >> 32);
-        const uint32_t word_3 = *++casted_data_32;
-        const uint32_t word_4 = *++casted_data_32;
-        const uint32_t word_5 = *++casted_data_32;
-        const uint32_t word_6 = *++casted_data_32;
-        const uint32_t word_7 = *++casted_data_32;
-        const uint32_t word_8 = *++casted_data_32;
-
-        crc_ = lookup_table_[0][(word_8 >> 24) & 0xFF] ^
-               lookup_table_[1][(word_8 >> 16) & 0xFF] ^
-               lookup_table_[2][(word_8 >> 8) & 0xFF] ^
-               lookup_table_[3][(word_8)&0xFF] ^
-               lookup_table_[4][(word_7 >> 24) & 0xFF] ^
-               lookup_table_[5][(word_7 >> 16) & 0xFF] ^
-               lookup_table_[6][(word_7 >> 8) & 0xFF] ^
-               lookup_table_[7][word_7 & 0xFF];
-        crc_ ^= lookup_table_[8][(word_6 >> 24) & 0xFF] ^
-                lookup_table_[9][(word_6 >> 16) & 0xFF] ^
-                lookup_table_[10][(word_6 >> 8) & 0xFF] ^
-                lookup_table_[11][(word_6)&0xFF] ^
-                lookup_table_[12][(word_5 >> 24) & 0xFF] ^
-                lookup_table_[13][(word_5 >> 16) & 0xFF] ^
-                lookup_table_[14][(word_5 >> 8) & 0xFF] ^
-                lookup_table_[15][word_5 & 0xFF];
-        crc_ ^= lookup_table_[16][(word_4 >> 24) & 0xFF] ^
-                lookup_table_[17][(word_4 >> 16) & 0xFF] ^
-                lookup_table_[18][(word_4 >> 8) & 0xFF] ^
-                lookup_table_[19][(word_4)&0xFF] ^
-                lookup_table_[20][(word_3 >> 24) & 0xFF] ^
-                lookup_table_[21][(word_3 >> 16) & 0xFF] ^
-                lookup_table_[22][(word_3 >> 8) & 0xFF] ^
-                lookup_table_[23][word_3 & 0xFF];
-        crc_ ^= lookup_table_[24][(word_2 >> 24) & 0xFF] ^
-                lookup_table_[25][(word_2 >> 16) & 0xFF] ^
-                lookup_table_[26][(word_2 >> 8) & 0xFF] ^
-                lookup_table_[27][(word_2)&0xFF] ^
-                lookup_table_[28][(word_1 >> 24) & 0xFF] ^
-                lookup_table_[29][(word_1 >> 16) & 0xFF] ^
-                lookup_table_[30][(word_1 >> 8) & 0xFF] ^
-                lookup_table_[31][word_1 & 0xFF];
+        const uint32_t word_3 = FromLittleEndian(*++casted_data_32);
+        const uint32_t word_4 = FromLittleEndian(*++casted_data_32);
+        const uint32_t word_5 = FromLittleEndian(*++casted_data_32);
+        const uint32_t word_6 = FromLittleEndian(*++casted_data_32);
+        const uint32_t word_7 = FromLittleEndian(*++casted_data_32);
+        const uint32_t word_8 = FromLittleEndian(*++casted_data_32);
+
+        crc = table.lookup[0][(word_8 >> 24) & 0xFF] ^
+               table.lookup[1][(word_8 >> 16) & 0xFF] ^
+               table.lookup[2][(word_8 >> 8) & 0xFF] ^
+               table.lookup[3][(word_8)&0xFF] ^
+               table.lookup[4][(word_7 >> 24) & 0xFF] ^
+               table.lookup[5][(word_7 >> 16) & 0xFF] ^
+               table.lookup[6][(word_7 >> 8) & 0xFF] ^
+               table.lookup[7][word_7 & 0xFF];
+        crc ^= table.lookup[8][(word_6 >> 24) & 0xFF] ^
+                table.lookup[9][(word_6 >> 16) & 0xFF] ^
+                table.lookup[10][(word_6 >> 8) & 0xFF] ^
+                table.lookup[11][(word_6)&0xFF] ^
+                table.lookup[12][(word_5 >> 24) & 0xFF] ^
+                table.lookup[13][(word_5 >> 16) & 0xFF] ^
+                table.lookup[14][(word_5 >> 8) & 0xFF] ^
+                table.lookup[15][word_5 & 0xFF];
+        crc ^= table.lookup[16][(word_4 >> 24) & 0xFF] ^
+                table.lookup[17][(word_4 >> 16) & 0xFF] ^
+                table.lookup[18][(word_4 >> 8) & 0xFF] ^
+                table.lookup[19][(word_4)&0xFF] ^
+                table.lookup[20][(word_3 >> 24) & 0xFF] ^
+                table.lookup[21][(word_3 >> 16) & 0xFF] ^
+                table.lookup[22][(word_3 >> 8) & 0xFF] ^
+                table.lookup[23][word_3 & 0xFF];
+        crc ^= table.lookup[24][(word_2 >> 24) & 0xFF] ^
+                table.lookup[25][(word_2 >> 16) & 0xFF] ^
+                table.lookup[26][(word_2 >> 8) & 0xFF] ^
+                table.lookup[27][(word_2)&0xFF] ^
+                table.lookup[28][(word_1 >> 24) & 0xFF] ^
+                table.lookup[29][(word_1 >> 16) & 0xFF] ^
+                table.lookup[30][(word_1 >> 8) & 0xFF] ^
+                table.lookup[31][word_1 & 0xFF];
       }
       bytes_left -= bytes_at_once;
     }
   }
-  // Consume last bytes if any.
-  const auto* casted_data_8 =
-      reinterpret_cast<const uint8_t*>(++casted_data_32);
-  Consume_byte_by_byte(casted_data_8, bytes_left);
+  // Consume last words and bytes if any.
+  return ConsumeTail(table, crc,
+                     reinterpret_cast<const uint8_t*>(++casted_data_32),
+                     bytes_left);
+}
+
+template <typename T, bool reflected>
+uint64_t CrcKernels<T, reflected>::Register_64b(T crc) noexcept {
+  if constexpr (reflected) {
+    return static_cast<uint64_t>(crc);
+  } else {
+    return static_cast<uint64_t>(SwapEndianess(crc));
+  }
+}
+
+// Register is at most 64 bits wide, so the first word of every step absorbs
+// it completely, without any shifts of the register.
+template <typename T, bool reflected>
+T CrcKernels<T, reflected>::Consume_1x64b(const CrcTable<T>& table, T crc,
+                                          const uint8_t* data, size_t size) {
+  crc = ConsumeHead(table, crc, &data, &size, alignof(uint64_t));
+  // Cast provided data to match template type.
+  const auto* casted_data_64 = reinterpret_cast<const uint64_t*>(data);
+  size_t bytes_left = size;
+  static constexpr uint8_t unroll = 8;
+  static constexpr uint32_t bytes_at_once = sizeof(uint64_t) * unroll;
+  --casted_data_64;
+  while (bytes_left >= bytes_at_once) {
+    for (size_t i = 0; i < unroll; ++i) {
+      const uint64_t word_1 =
+          FromLittleEndian(*++casted_data_64) ^ Register_64b(crc);
+      crc = table.lookup[7][word_1 & 0xFF] ^
+             table.lookup[6][(word_1 >> 8) & 0xFF] ^
+             table.lookup[5][(word_1 >> 16) & 0xFF] ^
+             table.lookup[4][(word_1 >> 24) & 0xFF] ^
+             table.lookup[3][(word_1 >> 32) & 0xFF] ^
+             table.lookup[2][(word_1 >> 40) & 0xFF] ^
+             table.lookup[1][(word_1 >> 48) & 0xFF] ^
+             table.lookup[0][(word_1 >> 56) & 0xFF];
+    }
+    bytes_left -= bytes_at_once;
+  }
+  // Consume last words and bytes if any.
+  return ConsumeTail(table, crc,
+                     reinterpret_cast<const uint8_t*>(++casted_data_64),
+                     bytes_left);
+}
+
+template <typename T, bool reflected>
+T CrcKernels<T, reflected>::Consume_2x64b(const CrcTable<T>& table, T crc,
+                                          const uint8_t* data, size_t size) {
+  crc = ConsumeHead(table, crc, &data, &size, alignof(uint64_t));
+  // Cast provided data to match template type.
+  const auto* casted_data_64 = reinterpret_cast<const uint64_t*>(data);
+  size_t bytes_left = size;
+  static constexpr uint8_t unroll = 4;
+  static constexpr uint32_t bytes_at_once = sizeof(uint64_t) * 2 * unroll;
+  --casted_data_64;
+  while (bytes_left >= bytes_at_once) {
+    for (size_t i = 0; i < unroll; ++i) {
+      const uint64_t word_1 =
+          FromLittleEndian(*++casted_data_64) ^ Register_64b(crc);
+      const uint64_t word_2 = FromLittleEndian(*++casted_data_64);
+      crc = table.lookup[7][word_2 & 0xFF] ^
+             table.lookup[6][(word_2 >> 8) & 0xFF] ^
+             table.lookup[5][(word_2 >> 16) & 0xFF] ^
+             table.lookup[4][(word_2 >> 24) & 0xFF] ^
+             table.lookup[3][(word_2 >> 32) & 0xFF] ^
+             table.lookup[2][(word_2 >> 40) & 0xFF] ^
+             table.lookup[1][(word_2 >> 48) & 0xFF] ^
+             table.lookup[0][(word_2 >> 56) & 0xFF];
+      crc ^= table.lookup[15][word_1 & 0xFF] ^
+              table.lookup[14][(word_1 >> 8) & 0xFF] ^
+              table.lookup[13][(word_1 >> 16) & 0xFF] ^
+              table.lookup[12][(word_1 >> 24) & 0xFF] ^
+              table.lookup[11][(word_1 >> 32) & 0xFF] ^
+              table.lookup[10][(word_1 >> 40) & 0xFF] ^
+              table.lookup[9][(word_1 >> 48) & 0xFF] ^
+              table.lookup[8][(word_1 >> 56) & 0xFF];
+    }
+    bytes_left -= bytes_at_once;
+  }
+  // Consume last words and bytes if any.
+  return ConsumeTail(table, crc,
+                     reinterpret_cast<const uint8_t*>(++casted_data_64),
+                     bytes_left);
+}
+
+template <typename T, bool reflected>
+T CrcKernels<T, reflected>::Consume_4x64b(const CrcTable<T>& table, T crc,
+                                          const uint8_t* data, size_t size) {
+  crc = ConsumeHead(table, crc, &data, &size, alignof(uint64_t));
+  // Cast provided data to match template type.
+  const auto* casted_data_64 = reinterpret_cast<const uint64_t*>(data);
+  size_t bytes_left = size;
+  static constexpr uint8_t unroll = 2;
+  static constexpr uint32_t bytes_at_once = sizeof(uint64_t) * 4 * unroll;
+  --casted_data_64;
+  while (bytes_left >= bytes_at_once) {
+    for (size_t i = 0; i < unroll; ++i) {
+      const uint64_t word_1 =
+          FromLittleEndian(*++casted_data_64) ^ Register_64b(crc);
+      const uint64_t word_2 = FromLittleEndian(*++casted_data_64);
+      const uint64_t word_3 = FromLittleEndian(*++casted_data_64);
+      const uint64_t word_4 = FromLittleEndian(*++casted_data_64);
+      crc = table.lookup[7][word_4 & 0xFF] ^
+             table.lookup[6][(word_4 >> 8) & 0xFF] ^
+             table.lookup[5][(word_4 >> 16) & 0xFF] ^
+             table.lookup[4][(word_4 >> 24) & 0xFF] ^
+             table.lookup[3][(word_4 >> 32) & 0xFF] ^
+             table.lookup[2][(word_4 >> 40) & 0xFF] ^
+             table.lookup[1][(word_4 >> 48) & 0xFF] ^
+             table.lookup[0][(word_4 >> 56) & 0xFF];
+      crc ^= table.lookup[15][word_3 & 0xFF] ^
+              table.lookup[14][(word_3 >> 8) & 0xFF] ^
+              table.lookup[13][(word_3 >> 16) & 0xFF] ^
+              table.lookup[12][(word_3 >> 24) & 0xFF] ^
+              table.lookup[11][(word_3 >> 32) & 0xFF] ^
+              table.lookup[10][(word_3 >> 40) & 0xFF] ^
+              table.lookup[9][(word_3 >> 48) & 0xFF] ^
+              table.lookup[8][(word_3 >> 56) & 0xFF];
+      crc ^= table.lookup[23][word_2 & 0xFF] ^
+              table.lookup[22][(word_2 >> 8) & 0xFF] ^
+              table.lookup[21][(word_2 >> 16) & 0xFF] ^
+              table.lookup[20][(word_2 >> 24) & 0xFF] ^
+              table.lookup[19][(word_2 >> 32) & 0xFF] ^
+              table.lookup[18][(word_2 >> 40) & 0xFF] ^
+              table.lookup[17][(word_2 >> 48) & 0xFF] ^
+              table.lookup[16][(word_2 >> 56) & 0xFF];
+      crc ^= table.lookup[31][word_1 & 0xFF] ^
+              table.lookup[30][(word_1 >> 8) & 0xFF] ^
+              table.lookup[29][(word_1 >> 16) & 0xFF] ^
+              table.lookup[28][(word_1 >> 24) & 0xFF] ^
+              table.lookup[27][(word_1 >> 32) & 0xFF] ^
+              table.lookup[26][(word_1 >> 40) & 0xFF] ^
+              table.lookup[25][(word_1 >> 48) & 0xFF] ^
+              table.lookup[24][(word_1 >> 56) & 0xFF];
+    }
+    bytes_left -= bytes_at_once;
+  }
+  // Consume last words and bytes if any.
+  return ConsumeTail(table, crc,
+                     reinterpret_cast<const uint8_t*>(++casted_data_64),
+                     bytes_left);
+}
+
+template <typename T, bool reflected>
+T CrcKernels<T, reflected>::Consume_gather(const CrcTable<T>& table, T crc,
+                                           const uint8_t* data, size_t size) {
+  static constexpr size_t block = hw::kGatherLanes * kGatherSegment;
+  if constexpr (std::is_same_v<T, uint32_t>) {
+    if (hw::GetCpuFeatures().avx2 && size >= block) {
+      const T shift = XPowMod(table.polynomial, 8 * kGatherSegment);
+      for (; size >= block; data += block, size -= block) {
+        // Every stream but the first one starts with an empty register.
+        T lane_crc[hw::kGatherLanes] = {crc};
+        const uint8_t* lane_data[hw::kGatherLanes];
+        for (size_t lane = 0; lane < hw::kGatherLanes; ++lane) {
+          lane_data[lane] = data + lane * kGatherSegment;
+        }
+        hw::GatherLanes(lane_crc, lane_data, kGatherSegment, reflected,
+                        table.lookup);
+        crc = lane_crc[0];
+        for (size_t lane = 1; lane < hw::kGatherLanes; ++lane) {
+          crc = ShiftRegister(crc, shift, table.polynomial, reflected) ^
+                lane_crc[lane];
+        }
+      }
+    }
+  }
+  return Consume_8x32b(table, crc, data, size);
+}
+
+template <typename T, bool reflected>
+T CrcKernels<T, reflected>::Consume_hw(const CrcTable<T>& table, T crc,
+                                      const uint8_t* data, size_t size) {
+  const hw::CpuFeatures& features = hw::GetCpuFeatures();
+  // Dedicated instructions for CRC32 / CRC32C.
+  if (sizeof(T) == sizeof(uint32_t) && reflected) {
+    if (table.polynomial == static_cast<T>(hw::detail::kPolynomialCrc32c) &&
+        features.crc32c) {
+      return static_cast<T>(
+          hw::Crc32c(static_cast<uint32_t>(crc), data, size));
+    }
+    if (table.polynomial == static_cast<T>(hw::detail::kPolynomialCrc32) &&
+        features.crc32) {
+      return static_cast<T>(hw::Crc32(static_cast<uint32_t>(crc), data, size));
+    }
+  }
+  if (!features.clmul) {
+    return Consume_8x32b(table, crc, data, size);
+  }
+  uint8_t remainder[16];
+  const size_t consumed =
+      hw::ClmulFold(static_cast<uint64_t>(crc), sizeof(T) * 8, reflected,
+                    table.fold, data, size, remainder);
+  if (consumed > 0) {
+    crc = Consume_1x32b(table, 0, remainder, sizeof(remainder));
+  }
+  return Consume_1x32b(table, crc, data + consumed, size - consumed);
+}
+
+template <typename T, bool reflected>
+bool CrcKernels<T, reflected>::HasLaneInstructions(
+    const CrcTable<T>& table) noexcept {
+  if constexpr (std::is_same_v<T, uint32_t> && reflected) {
+    const hw::CpuFeatures& features = hw::GetCpuFeatures();
+    return (table.polynomial == hw::detail::kPolynomialCrc32c &&
+            features.crc32c) ||
+           (table.polynomial == hw::detail::kPolynomialCrc32 &&
+            features.crc32);
+  }
+  return false;
+}
+
+template <typename T, bool reflected>
+T CrcKernels<T, reflected>::Step_2x32b(const CrcTable<T>& table, T crc,
+                                       const uint8_t* data) {
+  uint32_t word_1;
+  uint32_t word_2;
+  std::memcpy(&word_1, data, sizeof(word_1));
+  std::memcpy(&word_2, data + sizeof(word_1), sizeof(word_2));
+  word_1 = FromLittleEndian(word_1);
+  word_2 = FromLittleEndian(word_2);
+  if constexpr (reflected) {
+    word_1 ^= static_cast<uint32_t>(crc);
+    word_2 ^= static_cast<uint32_t>(static_cast<uint64_t>(crc) >> 32);
+  } else {
+    const T swapped = SwapEndianess(crc);
+    word_1 ^= static_cast<uint32_t>(swapped);
+    word_2 ^= static_cast<uint32_t>(static_cast<uint64_t>(swapped) >> 32);
+  }
+  return table.lookup[0][(word_2 >> 24) & 0xFF] ^
+         table.lookup[1][(word_2 >> 16) & 0xFF] ^
+         table.lookup[2][(word_2 >> 8) & 0xFF] ^
+         table.lookup[3][word_2 & 0xFF] ^
+         table.lookup[4][(word_1 >> 24) & 0xFF] ^
+         table.lookup[5][(word_1 >> 16) & 0xFF] ^
+         table.lookup[6][(word_1 >> 8) & 0xFF] ^
+         table.lookup[7][word_1 & 0xFF];
+}
+
+template <typename T, bool reflected>
+void CrcKernels<T, reflected>::Consume_lanes(
+    const CrcTable<T>& table, T crc[hw::kLanes],
+    const uint8_t* const data[hw::kLanes], size_t size, CrcChunks chunks) {
+  // Dedicated instructions interleaved the same way as table lookups.
+  if constexpr (std::is_same_v<T, uint32_t> && reflected) {
+    if (chunks == HW_CLMUL && HasLaneInstructions(table)) {
+      if (table.polynomial == hw::detail::kPolynomialCrc32c) {
+        hw::Crc32cLanes(crc, data, size);
+      } else {
+        hw::Crc32Lanes(crc, data, size);
+      }
+      return;
+    }
+  }
+  static_assert(hw::kLanes == 4, "Lanes are unrolled by hand");
+  T crc_0 = crc[0];
+  T crc_1 = crc[1];
+  T crc_2 = crc[2];
+  T crc_3 = crc[3];
+  for (size_t i = 0; i < size; i += 8) {
+    crc_0 = Step_2x32b(table, crc_0, data[0] + i);
+    crc_1 = Step_2x32b(table, crc_1, data[1] + i);
+    crc_2 = Step_2x32b(table, crc_2, data[2] + i);
+    crc_3 = Step_2x32b(table, crc_3, data[3] + i);
+  }
+  crc[0] = crc_0;
+  crc[1] = crc_1;
+  crc[2] = crc_2;
+  crc[3] = crc_3;
+}
+
+template <typename T, bool reflected>
+void CrcKernels<T, reflected>::ConsumeBatch(const CrcTable<T>& table, T crc,
+                                            const CrcBuffer* buffers,
+                                            size_t count, CrcChunks chunks,
+                                            T* results) {
+  // Folding already processes 4 blocks of a buffer in parallel, lanes would
+  // only replace it with table lookups.
+  if (chunks == HW_CLMUL && hw::GetCpuFeatures().clmul &&
+      !HasLaneInstructions(table)) {
+    for (size_t i = 0; i < count; ++i) {
+      results[i] =
+          Consume_hw(table, crc, static_cast<const uint8_t*>(buffers[i].data),
+                     buffers[i].size);
+    }
+    return;
+  }
+  if constexpr (std::is_same_v<T, uint32_t>) {
+    if (chunks == SIMD_GATHER && hw::GetCpuFeatures().avx2) {
+      ConsumeBatchLanes<hw::kGatherLanes, sizeof(uint32_t)>(
+          table, crc, buffers, count, chunks, results,
+          [&](T* lane_crc, const uint8_t* const* lane_data, size_t size) {
+            hw::GatherLanes(lane_crc, lane_data, size, reflected,
+                            table.lookup);
+          });
+      return;
+    }
+  }
+  ConsumeBatchLanes<hw::kLanes, sizeof(uint64_t)>(
+      table, crc, buffers, count, chunks, results,
+      [&](T* lane_crc, const uint8_t* const* lane_data, size_t size) {
+        Consume_lanes(table, lane_crc, lane_data, size, chunks);
+      });
+}
+
+template <typename T, bool reflected>
+template <size_t lanes_count, size_t word, typename Kernel>
+void CrcKernels<T, reflected>::ConsumeBatchLanes(
+    const CrcTable<T>& table, T crc, const CrcBuffer* buffers, size_t count,
+    CrcChunks chunks, T* results, Kernel kernel) {
+  // Every lane keeps its data until a lane runs out of full words, which is
+  // then finished with 'chunks' method and refilled with the next buffer.
+  T lane_crc[lanes_count];
+  const uint8_t* lane_data[lanes_count];
+  size_t lane_size[lanes_count];
+  size_t lane_index[lanes_count];
+  size_t next = 0;
+  const auto fill = [&](size_t lane) {
+    lane_crc[lane] = crc;
+    lane_data[lane] = static_cast<const uint8_t*>(buffers[next].data);
+    lane_size[lane] = buffers[next].size;
+    lane_index[lane] = next++;
+  };
+  const auto finish = [&](size_t lane) {
+    results[lane_index[lane]] = Consume(table, lane_crc[lane], lane_data[lane],
+                                        lane_size[lane], chunks);
+  };
+  size_t lanes = std::min(count, lanes_count);
+  for (size_t lane = 0; lane < lanes; ++lane) {
+    fill(lane);
+  }
+  while (lanes == lanes_count) {
+    size_t step = SIZE_MAX;
+    for (size_t lane = 0; lane < lanes; ++lane) {
+      while (lane_size[lane] < word && lanes == lanes_count) {
+        finish(lane);
+        if (next == count) {
+          // Move the last lane into the finished one.
+          --lanes;
+          lane_crc[lane] = lane_crc[lanes];
+          lane_data[lane] = lane_data[lanes];
+          lane_size[lane] = lane_size[lanes];
+          lane_index[lane] = lane_index[lanes];
+        } else {
+          fill(lane);
+        }
+      }
+      step = std::min(step, lane_size[lane]);
+    }
+    if (lanes < lanes_count) {
+      break;
+    }
+    step -= step % word;
+    kernel(lane_crc, lane_data, step);
+    for (size_t lane = 0; lane < lanes; ++lane) {
+      lane_data[lane] += step;
+      lane_size[lane] -= step;
+    }
+  }
+  for (size_t lane = 0; lane < lanes; ++lane) {
+    finish(lane);
+  }
+}
+
+template <typename T, bool reflected>
+T CrcKernels<T, reflected>::Consume(const CrcTable<T>& table, T crc,
+                                   const uint8_t* data, size_t size,
+                                   CrcChunks chunks) {
+  switch (chunks) {
+    case CHUNKS_AUTO:
+      return Consume(table, crc, data, size,
+                     CrcDispatcher<T>::Get(reflected, size));
+    case HW_CLMUL:
+      return Consume_hw(table, crc, data, size);
+    case SIMD_GATHER:
+      return Consume_gather(table, crc, data, size);
+    case CHUNKS_4x64b:
+      return Consume_4x64b(table, crc, data, size);
+    case CHUNKS_2x64b:
+      return Consume_2x64b(table, crc, data, size);
+    case CHUNKS_1x64b:
+      return Consume_1x64b(table, crc, data, size);
+    case CHUNKS_8x32b:
+      return Consume_8x32b(table, crc, data, size);
+    case CHUNKS_4x32b:
+      return Consume_4x32b(table, crc, data, size);
+    case CHUNKS_2x32b:
+      return Consume_2x32b(table, crc, data, size);
+    case CHUNKS_1x32b:
+      return Consume_1x32b(table, crc, data, size);
+    case BYTE_BY_BYTE:
+      return Consume_byte_by_byte(table, crc, data, size);
+  }
+  return crc;
 }
 
+}  // namespace detail
+
 template <typename T>
 T Crc<T>::crc() const noexcept {
-  return (reverse_out_ ^ reverse_data_) ? ReverseBits(crc_) ^ xor_output_
-                                        : crc_ ^ xor_output_;
+  return Finalize(crc_);
 }
 
 template <typename T>
 void Crc<T>::reset() noexcept {
-  crc_ = (reverse_data_) ? ReverseBits(initial_crc_) : initial_crc_;
+  crc_ = detail::InitialRegister(initial_crc_, reverse_data_);
+}
+
+template <typename T>
+T Crc<T>::Combine(T crc_a, T crc_b, uint64_t size_b) const noexcept {
+  const T combined = detail::CombineCrc(
+      static_cast<T>(crc_a << out_shift_), static_cast<T>(crc_b << out_shift_),
+      size_b, polynomial_, initial_crc_, xor_output_, reverse_out_);
+  return static_cast<T>(combined >> out_shift_);
+}
+
+template <typename T>
+template <typename Y>
+T Crc<T>::Update(T crc, uint64_t offset, const Y* old_data, const Y* new_data,
+                 size_t size, uint64_t total_size) const noexcept {
+  const auto* old_8 = reinterpret_cast<const uint8_t*>(old_data);
+  const auto* new_8 = reinterpret_cast<const uint8_t*>(new_data);
+  const size_t bytes = size * sizeof(Y);
+  assert(offset <= total_size && bytes <= total_size - offset);
+  if (offset > total_size || bytes > total_size - offset) {
+    return crc;
+  }
+  const CrcChunks chunks = Resolve(bytes);
+  // Difference of both messages is zero outside of the changed bytes. Its
+  // register, without initial value and output xor, is the difference of
+  // both CRC values.
+  uint8_t delta[256];
+  T diff = 0;
+  for (size_t done = 0; done < bytes; done += sizeof(delta)) {
+    const size_t block = std::min(sizeof(delta), bytes - done);
+    for (size_t i = 0; i < block; ++i) {
+      delta[i] = old_8[done + i] ^ new_8[done + i];
+    }
+    diff = Advance(*table_, diff, delta, block, chunks);
+  }
+  const uint64_t following = total_size - offset - bytes;
+  const T shift = detail::XPowMod(polynomial_, 8 * following);
+  diff = detail::ShiftRegister(diff, shift, polynomial_, reverse_data_);
+  return crc ^ static_cast<T>(detail::FinalCrc(diff, static_cast<T>(0),
+                                               reverse_data_, reverse_out_) >>
+                              out_shift_);
+}
+
+template <typename T>
+size_t Crc<T>::table_footprint() const noexcept {
+  return table_->footprint();
+}
+
+template <typename T>
+const CrcStats& Crc<T>::stats() const noexcept {
+#if HASHLIB_CRC_STATS
+  return stats_;
+#else
+  static constexpr CrcStats empty;
+  return empty;
+#endif
+}
+
+template <typename T>
+void Crc<T>::reset_stats() noexcept {
+#if HASHLIB_CRC_STATS
+  stats_ = CrcStats();
+#endif
+}
+
+template <typename T, uint64_t polynomial, uint64_t initial_crc,
+          uint64_t xor_output, bool reverse_data, bool reverse_out>
+constexpr StaticCrc<T, polynomial, initial_crc, xor_output, reverse_data,
+                    reverse_out>::StaticCrc(CrcChunks chunks) noexcept
+    : crc_(detail::InitialRegister(static_cast<T>(initial_crc), reverse_data)),
+      chunks_(chunks) {}
+
+template <typename T, uint64_t polynomial, uint64_t initial_crc,
+          uint64_t xor_output, bool reverse_data, bool reverse_out>
+template <typename Y>
+void StaticCrc<T, polynomial, initial_crc, xor_output, reverse_data,
+               reverse_out>::Consume(const Y* data, size_t size) noexcept {
+  Consume(data, size, chunks_);
+}
+
+template <typename T, uint64_t polynomial, uint64_t initial_crc,
+          uint64_t xor_output, bool reverse_data, bool reverse_out>
+template <typename Y>
+void StaticCrc<T, polynomial, initial_crc, xor_output, reverse_data,
+               reverse_out>::Consume(const Y* data, size_t size,
+                                     CrcChunks chunks) noexcept {
+  crc_ = Kernels::Consume(Table::value, crc_,
+                          reinterpret_cast<const uint8_t*>(data),
+                          size * sizeof(Y), chunks);
+}
+
+template <typename T, uint64_t polynomial, uint64_t initial_crc,
+          uint64_t xor_output, bool reverse_data, bool reverse_out>
+constexpr T StaticCrc<T, polynomial, initial_crc, xor_output, reverse_data,
+                      reverse_out>::crc() const noexcept {
+  return detail::FinalCrc(crc_, static_cast<T>(xor_output), reverse_data,
+                          reverse_out);
+}
+
+template <typename T, uint64_t polynomial, uint64_t initial_crc,
+          uint64_t xor_output, bool reverse_data, bool reverse_out>
+constexpr void StaticCrc<T, polynomial, initial_crc, xor_output, reverse_data,
+                         reverse_out>::reset() noexcept {
+  crc_ = detail::InitialRegister(static_cast<T>(initial_crc), reverse_data);
+}
+
+template <typename T, uint64_t polynomial, uint64_t initial_crc,
+          uint64_t xor_output, bool reverse_data, bool reverse_out>
+constexpr T StaticCrc<T, polynomial, initial_crc, xor_output, reverse_data,
+                      reverse_out>::Combine(T crc_a, T crc_b,
+                                            uint64_t size_b) noexcept {
+  return detail::CombineCrc(crc_a, crc_b, size_b, static_cast<T>(polynomial),
+                            static_cast<T>(initial_crc),
+                            static_cast<T>(xor_output), reverse_out);
+}
+
+template <typename T, uint64_t polynomial, uint64_t initial_crc,
+          uint64_t xor_output, bool reverse_data, bool reverse_out>
+constexpr T StaticCrc<T, polynomial, initial_crc, xor_output, reverse_data,
+                      reverse_out>::Checksum(std::string_view data) noexcept {
+  const T crc = detail::ConsumeConstexpr(
+      Table::storage.values,
+      detail::InitialRegister(static_cast<T>(initial_crc), reverse_data),
+      reverse_data, data);
+  return detail::FinalCrc(crc, static_cast<T>(xor_output), reverse_data,
+                          reverse_out);
 }
 
 // Some of the most popoular CRC options.
+OptionsCrc constexpr OptionsCrc::Crc8() {
+  return OptionsCrc(static_cast<uint64_t>(0x07), static_cast<uint64_t>(0x00),
+                    static_cast<uint64_t>(0x00), false, false, CHUNKS_AUTO, 8);
+}
+
+OptionsCrc constexpr OptionsCrc::Crc8_MAXIM() {
+  return OptionsCrc(static_cast<uint64_t>(0x31), static_cast<uint64_t>(0x00),
+                    static_cast<uint64_t>(0x00), true, true, CHUNKS_AUTO, 8);
+}
+
+OptionsCrc constexpr OptionsCrc::Crc15_CAN() {
+  return OptionsCrc(static_cast<uint64_t>(0x4599),
+                    static_cast<uint64_t>(0x0000),
+                    static_cast<uint64_t>(0x0000), false, false, CHUNKS_AUTO,
+                    15);
+}
+
 OptionsCrc constexpr OptionsCrc::Crc16() {
   return OptionsCrc(static_cast<uint64_t>(0x8005),
                     static_cast<uint64_t>(0x0000),
@@ -653,12 +2469,39 @@ OptionsCrc constexpr OptionsCrc::Crc16_CCITT() {
                     static_cast<uint64_t>(0x0000), false, false);
 }
 
+OptionsCrc constexpr OptionsCrc::Crc24_OPENPGP() {
+  return OptionsCrc(static_cast<uint64_t>(0x864CFB),
+                    static_cast<uint64_t>(0xB704CE),
+                    static_cast<uint64_t>(0x000000), false, false, CHUNKS_AUTO,
+                    24);
+}
+
+OptionsCrc constexpr OptionsCrc::Crc24_BLE() {
+  return OptionsCrc(static_cast<uint64_t>(0x00065B),
+                    static_cast<uint64_t>(0x555555),
+                    static_cast<uint64_t>(0x000000), true, true, CHUNKS_AUTO,
+                    24);
+}
+
 OptionsCrc constexpr OptionsCrc::Crc32() {
   return OptionsCrc(static_cast<uint64_t>(0x4C11DB7),
                     static_cast<uint64_t>(0xFFFFFFFF),
                     static_cast<uint64_t>(0xFFFFFFFF), true, true);
 }
 
+OptionsCrc constexpr OptionsCrc::Crc32C() {
+  return OptionsCrc(static_cast<uint64_t>(0x1EDC6F41),
+                    static_cast<uint64_t>(0xFFFFFFFF),
+                    static_cast<uint64_t>(0xFFFFFFFF), true, true);
+}
+
+OptionsCrc constexpr OptionsCrc::Crc40_GSM() {
+  return OptionsCrc(static_cast<uint64_t>(0x0004820009),
+                    static_cast<uint64_t>(0x0000000000),
+                    static_cast<uint64_t>(0xFFFFFFFFFF), false, false,
+                    CHUNKS_AUTO, 40);
+}
+
 OptionsCrc constexpr OptionsCrc::Crc64() {
   return OptionsCrc(static_cast<uint64_t>(0x42F0E1EBA9EA3693),
                     static_cast<uint64_t>(0xFFFFFFFFFFFFFFFF),
@@ -671,18 +2514,178 @@ OptionsCrc constexpr OptionsCrc::Crc64_ISO() {
                     static_cast<uint64_t>(0x0000000000000000), true, true);
 }
 
+namespace detail {
+
+template <typename T>
+const CrcTable<T>* FindPresetTable(T polynomial, bool reflected,
+                                   size_t slices) noexcept {
+  static constexpr OptionsCrc crc16 = OptionsCrc::Crc16();
+  static constexpr OptionsCrc crc16_ccitt = OptionsCrc::Crc16_CCITT();
+  static constexpr OptionsCrc crc32 = OptionsCrc::Crc32();
+  static constexpr OptionsCrc crc32c = OptionsCrc::Crc32C();
+  static constexpr OptionsCrc crc64 = OptionsCrc::Crc64();
+  static constexpr OptionsCrc crc64_iso = OptionsCrc::Crc64_ISO();
+  const auto matches = [&](const OptionsCrc& options) {
+    return polynomial == static_cast<T>(options.polynomial) &&
+           reflected == options.reverse_data;
+  };
+  if constexpr (sizeof(T) == sizeof(uint16_t)) {
+    if (matches(crc16)) {
+      return StaticCrcTable<T, crc16.polynomial,
+                            crc16.reverse_data>::Get(slices);
+    }
+    if (matches(crc16_ccitt)) {
+      return StaticCrcTable<T, crc16_ccitt.polynomial,
+                            crc16_ccitt.reverse_data>::Get(slices);
+    }
+  } else if constexpr (sizeof(T) == sizeof(uint32_t)) {
+    if (matches(crc32)) {
+      return StaticCrcTable<T, crc32.polynomial,
+                            crc32.reverse_data>::Get(slices);
+    }
+    if (matches(crc32c)) {
+      return StaticCrcTable<T, crc32c.polynomial,
+                            crc32c.reverse_data>::Get(slices);
+    }
+  } else if constexpr (sizeof(T) == sizeof(uint64_t)) {
+    if (matches(crc64)) {
+      return StaticCrcTable<T, crc64.polynomial,
+                            crc64.reverse_data>::Get(slices);
+    }
+    if (matches(crc64_iso)) {
+      return StaticCrcTable<T, crc64_iso.polynomial,
+                            crc64_iso.reverse_data>::Get(slices);
+    }
+  }
+  return nullptr;
+}
+
+// Lookup table generated at runtime, with only required number of slices.
+template <typename T>
+struct RuntimeCrcTable {
+  RuntimeCrcTable(T polynomial, bool reflected, size_t slices)
+      : storage(new T[slices][256]) {
+    GenerateLookupTable(polynomial, reflected, storage.get(), slices);
+    table.lookup = storage.get();
+    table.slices = slices;
+    table.fold = GenerateFoldConstants(polynomial, reflected);
+    table.polynomial = polynomial;
+  }
+
+  std::unique_ptr<T[][256]> storage;
+  CrcTable<T> table;
+};
+
+template <typename T>
+const CrcTable<T>* GetCrcTable(T polynomial, bool reflected, size_t slices) {
+  if (const CrcTable<T>* table =
+          FindPresetTable(polynomial, reflected, slices)) {
+    return table;
+  }
+  // Keep tables of processing methods in use only, instead of always
+  // generating all slices.
+  static constexpr size_t slice_counts[] = {1, 4, 8, 16, kMaxTableSlices};
+  for (const size_t count : slice_counts) {
+    if (count >= slices) {
+      slices = count;
+      break;
+    }
+  }
+  static std::mutex mutex;
+  static std::map<std::tuple<T, bool, size_t>,
+                  std::unique_ptr<const RuntimeCrcTable<T>>>
+      tables;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& table = tables[std::make_tuple(polynomial, reflected, slices)];
+  if (!table) {
+    table.reset(new RuntimeCrcTable<T>(polynomial, reflected, slices));
+  }
+  return &table->table;
+}
+
+}  // namespace detail
+
+// Compile time specialized versions of the most popular CRC options.
+using Crc16Static =
+    StaticCrc<uint16_t, OptionsCrc::Crc16().polynomial,
+              OptionsCrc::Crc16().initial_crc, OptionsCrc::Crc16().xor_output,
+              OptionsCrc::Crc16().reverse_data,
+              OptionsCrc::Crc16().reverse_out>;
+using Crc16_CCITTStatic =
+    StaticCrc<uint16_t, OptionsCrc::Crc16_CCITT().polynomial,
+              OptionsCrc::Crc16_CCITT().initial_crc,
+              OptionsCrc::Crc16_CCITT().xor_output,
+              OptionsCrc::Crc16_CCITT().reverse_data,
+              OptionsCrc::Crc16_CCITT().reverse_out>;
+using Crc32Static =
+    StaticCrc<uint32_t, OptionsCrc::Crc32().polynomial,
+              OptionsCrc::Crc32().initial_crc, OptionsCrc::Crc32().xor_output,
+              OptionsCrc::Crc32().reverse_data,
+              OptionsCrc::Crc32().reverse_out>;
+using Crc32CStatic =
+    StaticCrc<uint32_t, OptionsCrc::Crc32C().polynomial,
+              OptionsCrc::Crc32C().initial_crc,
+              OptionsCrc::Crc32C().xor_output,
+              OptionsCrc::Crc32C().reverse_data,
+              OptionsCrc::Crc32C().reverse_out>;
+using Crc64Static =
+    StaticCrc<uint64_t, OptionsCrc::Crc64().polynomial,
+              OptionsCrc::Crc64().initial_crc, OptionsCrc::Crc64().xor_output,
+              OptionsCrc::Crc64().reverse_data,
+              OptionsCrc::Crc64().reverse_out>;
+using Crc64_ISOStatic =
+    StaticCrc<uint64_t, OptionsCrc::Crc64_ISO().polynomial,
+              OptionsCrc::Crc64_ISO().initial_crc,
+              OptionsCrc::Crc64_ISO().xor_output,
+              OptionsCrc::Crc64_ISO().reverse_data,
+              OptionsCrc::Crc64_ISO().reverse_out>;
+
+// CRC of a string at compile time, e.g. to switch over protocol identifiers:
+//   switch (hash::Crc32Of(name)) {
+//     case hash::Crc32Of("GET"): ...
+// Character arrays, i.e. string literals, are hashed as a whole without the
+// terminating NUL, so Crc32Of("a\0b") covers 3 bytes.
+constexpr uint16_t Crc16Of(std::string_view data) noexcept {
+  return Crc16Static::Checksum(data);
+}
+constexpr uint32_t Crc32Of(std::string_view data) noexcept {
+  return Crc32Static::Checksum(data);
+}
+constexpr uint32_t Crc32COf(std::string_view data) noexcept {
+  return Crc32CStatic::Checksum(data);
+}
+constexpr uint64_t Crc64Of(std::string_view data) noexcept {
+  return Crc64Static::Checksum(data);
+}
+template <size_t N>
+constexpr uint16_t Crc16Of(const char (&data)[N]) noexcept {
+  return Crc16Of(std::string_view(data, N - 1));
+}
+template <size_t N>
+constexpr uint32_t Crc32Of(const char (&data)[N]) noexcept {
+  return Crc32Of(std::string_view(data, N - 1));
+}
+template <size_t N>
+constexpr uint32_t Crc32COf(const char (&data)[N]) noexcept {
+  return Crc32COf(std::string_view(data, N - 1));
+}
+template <size_t N>
+constexpr uint64_t Crc64Of(const char (&data)[N]) noexcept {
+  return Crc64Of(std::string_view(data, N - 1));
+}
+
 // Create CRC class with CRC16 parameters.
-static Crc<uint16_t> NewCrc16(const OptionsCrc& options = OptionsCrc::Crc16()) {
+inline Crc<uint16_t> NewCrc16(const OptionsCrc& options = OptionsCrc::Crc16()) {
   return Crc<uint16_t>(options);
 }
 
 // Create CRC class with CRC32 parameters.
-static Crc<uint32_t> NewCrc32(const OptionsCrc& options = OptionsCrc::Crc32()) {
+inline Crc<uint32_t> NewCrc32(const OptionsCrc& options = OptionsCrc::Crc32()) {
   return Crc<uint32_t>(options);
 }
 
 // Create CRC class with CRC64 parameters.
-static Crc<uint64_t> NewCrc64(const OptionsCrc& options = OptionsCrc::Crc64()) {
+inline Crc<uint64_t> NewCrc64(const OptionsCrc& options = OptionsCrc::Crc64()) {
   return Crc<uint64_t>(options);
 }
 
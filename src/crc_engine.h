@@ -0,0 +1,100 @@
+#ifndef CRC_ENGINE_H_
+#define CRC_ENGINE_H_
+
+#include <cstdint>  // uint8_t
+
+#include "crc.h"
+#include "crc_placement.h"
+
+namespace hash {
+
+// Register of a single stream consumed by CrcEngine. Register only, so any
+// number of concurrent streams costs sizeof(T) each.
+template <typename T>
+struct CrcState {
+  // Register, not the CRC value, see CrcEngine::crc().
+  T value;
+};
+
+// Immutable CRC parameters with the lookup table and the processing method,
+// shared by any number of threads. Streams keep their own CrcState, consumed
+// through the const engine, so no synchronization is needed.
+// With node local 'placement', every NUMA node consumes its own copy of the
+// table (see CrcTablePlacement), selected by the node of the calling thread.
+// Counters of CrcStats are not collected by the engine.
+template <typename T>
+class CrcEngine {
+ public:
+  CrcEngine() = delete;
+  explicit CrcEngine(const OptionsCrc& options,
+                     CrcTablePlacement placement = TABLE_SHARED)
+      : crc_(options), placement_(placement) {}
+  // Share parameters and the table of an existing instance, e.g. after
+  // Crc::Optimize(). Its current CRC value is not used.
+  explicit CrcEngine(const Crc<T>& crc,
+                     CrcTablePlacement placement = TABLE_SHARED)
+      : crc_(crc), placement_(placement) {}
+  ~CrcEngine() = default;
+
+  // State with the initial register.
+  CrcState<T> NewState() const noexcept;
+  // Consume specified number of elements from given array of any type into
+  // 'state'. Never allocates, except for the first node local table copy.
+  template <typename Y>
+  void Consume(CrcState<T>& state, const Y* data, size_t size) const noexcept;
+
+  // Retrieve CRC value of 'state'.
+  T crc(const CrcState<T>& state) const noexcept;
+  // Reset 'state' to the initial register.
+  void reset(CrcState<T>& state) const noexcept;
+
+  // See Crc::Combine() and Crc::ChecksumBatch().
+  T Combine(T crc_a, T crc_b, uint64_t size_b) const noexcept;
+  void ChecksumBatch(const CrcBuffer* buffers, size_t count, T* results) const;
+
+ private:
+  // Holds the parameters only, its register is never modified.
+  const Crc<T> crc_;
+  const CrcTablePlacement placement_;
+};
+
+template <typename T>
+CrcState<T> CrcEngine<T>::NewState() const noexcept {
+  return {detail::InitialRegister(crc_.initial_crc_, crc_.reverse_data_)};
+}
+
+template <typename T>
+template <typename Y>
+void CrcEngine<T>::Consume(CrcState<T>& state, const Y* data,
+                           size_t size) const noexcept {
+  const size_t bytes = size * sizeof(Y);
+  const CrcTable<T>* table = detail::NodeLocalTable(crc_.table_, placement_);
+  state.value =
+      crc_.Advance(*table, state.value, reinterpret_cast<const uint8_t*>(data),
+                   bytes, crc_.Resolve(bytes));
+}
+
+template <typename T>
+T CrcEngine<T>::crc(const CrcState<T>& state) const noexcept {
+  return crc_.Finalize(state.value);
+}
+
+template <typename T>
+void CrcEngine<T>::reset(CrcState<T>& state) const noexcept {
+  state = NewState();
+}
+
+template <typename T>
+T CrcEngine<T>::Combine(T crc_a, T crc_b, uint64_t size_b) const noexcept {
+  return crc_.Combine(crc_a, crc_b, size_b);
+}
+
+template <typename T>
+void CrcEngine<T>::ChecksumBatch(const CrcBuffer* buffers, size_t count,
+                                 T* results) const {
+  crc_.ChecksumBatch(buffers, count, results);
+}
+
+}  // namespace hash
+
+#endif  // CRC_ENGINE_H_
@@ -0,0 +1,853 @@
+#ifndef CRC_HW_H_
+#define CRC_HW_H_
+
+#include <algorithm>  // std::min
+#include <chrono>     // std::chrono::steady_clock
+#include <cstddef>    // size_t
+#include <cstdint>    // uint8_t / uint32_t / uint64_t
+#include <cstring>    // std::memcpy
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define HASHLIB_HW_X86_64 1
+#if defined(_MSC_VER)
+#include <intrin.h>  // __cpuid
+#else
+#include <cpuid.h>     // __get_cpuid
+#include <x86intrin.h>  // __rdtsc
+#endif
+#include <immintrin.h>  // _mm_crc32_u64 / _mm_clmulepi64_si128
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+#define HASHLIB_HW_AARCH64 1
+#include <arm_acle.h>  // __crc32d / __crc32cd
+#include <arm_neon.h>  // vmull_p64
+#if defined(__linux__)
+#include <sys/auxv.h>  // getauxval
+#ifndef HWCAP_PMULL
+#define HWCAP_PMULL (1 << 4)
+#endif
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+#endif
+#endif
+
+// Allow usage of instruction set extensions in selected functions only, so
+// the rest of the code does not require any special compiler flags.
+#if defined(__GNUC__) || defined(__clang__)
+#define HASHLIB_TARGET(features) __attribute__((target(features)))
+#else
+#define HASHLIB_TARGET(features)
+#endif
+
+// GCC and Clang use different names for AArch64 extensions.
+#if defined(__clang__)
+#define HASHLIB_TARGET_ARM_CRC HASHLIB_TARGET("crc")
+#define HASHLIB_TARGET_ARM_PMULL HASHLIB_TARGET("aes")
+#define HASHLIB_TARGET_ARM_CRC_PMULL HASHLIB_TARGET("crc,aes")
+#else
+#define HASHLIB_TARGET_ARM_CRC HASHLIB_TARGET("+crc")
+#define HASHLIB_TARGET_ARM_PMULL HASHLIB_TARGET("+crypto")
+#define HASHLIB_TARGET_ARM_CRC_PMULL HASHLIB_TARGET("+crc+crypto")
+#endif
+
+namespace hash {
+namespace hw {
+
+// Instruction set extensions used by the hardware accelerated kernels.
+struct CpuFeatures {
+  bool crc32 = false;   // Dedicated CRC32 instruction (ARMv8 CRC).
+  bool crc32c = false;  // Dedicated CRC32C instruction (SSE4.2, ARMv8 CRC).
+  bool clmul = false;   // Carry-less multiplication (PCLMULQDQ, PMULL).
+  bool avx2 = false;    // Vector gathers with 256-bit registers.
+  bool avx512 = false;  // Vector gathers with 512-bit registers.
+};
+
+// Constants used to fold 128-bit blocks of data with carry-less
+// multiplication. Each pair multiplies low and high 64-bit halves of the
+// accumulator by the x^n mod P value matching the folding distance.
+struct FoldConstants {
+  uint64_t fold_512_lo = 0;
+  uint64_t fold_512_hi = 0;
+  uint64_t fold_128_lo = 0;
+  uint64_t fold_128_hi = 0;
+};
+
+const CpuFeatures& GetCpuFeatures() noexcept;
+
+// Cheap monotonic counter: time stamp counter on x86-64, virtual counter on
+// AArch64, steady clock nanoseconds elsewhere. Only differences of the values
+// are meaningful.
+inline uint64_t ReadCycles() noexcept {
+#if defined(HASHLIB_HW_X86_64)
+  return __rdtsc();
+#elif defined(HASHLIB_HW_AARCH64)
+  uint64_t value;
+  asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+  return value;
+#else
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+#endif
+}
+
+// Number of independent streams processed by Crc32Lanes / Crc32cLanes.
+constexpr size_t kLanes = 4;
+
+// Update reflected CRC32 / CRC32C register with given data.
+uint32_t Crc32(uint32_t crc, const uint8_t* data, size_t size) noexcept;
+uint32_t Crc32c(uint32_t crc, const uint8_t* data, size_t size) noexcept;
+
+// Number of streams processed by GatherLanes.
+constexpr size_t kGatherLanes = 16;
+
+// Update 'kGatherLanes' independent 32-bit registers, each with 'size' bytes
+// of its own data, gathering values from the first 4 slices of 'lookup'.
+// 'size' has to be a multiple of 4. Requires avx2 feature.
+void GatherLanes(uint32_t crc[kGatherLanes],
+                 const uint8_t* const data[kGatherLanes], size_t size,
+                 bool reflected, const uint32_t (*lookup)[256]) noexcept;
+
+// Update 'kLanes' independent reflected CRC32 / CRC32C registers, each with
+// 'size' bytes of its own data. 'size' has to be a multiple of 8.
+void Crc32Lanes(uint32_t crc[kLanes], const uint8_t* const data[kLanes],
+                size_t size) noexcept;
+void Crc32cLanes(uint32_t crc[kLanes], const uint8_t* const data[kLanes],
+                 size_t size) noexcept;
+
+// Fold as many 16 byte blocks of data as possible into single 128-bit
+// remainder. 'crc' is the current register with 'bits' width. Returns number
+// of consumed bytes (0 if 'size' is too small). The CRC of consumed data is
+// equal to the CRC of 'remainder' computed with register set to 0.
+size_t ClmulFold(uint64_t crc, size_t bits, bool reflected,
+                 const FoldConstants& constants, const uint8_t* data,
+                 size_t size, uint8_t remainder[16]) noexcept;
+
+// Copy 'size' bytes with non-temporal stores, which bypass the caches, so a
+// large destination does not evict the data being consumed. Plain memcpy
+// where no such stores are available. Buffers must not overlap.
+void CopyStreaming(uint8_t* dst, const uint8_t* src, size_t size) noexcept;
+
+namespace detail {
+
+constexpr uint32_t kPolynomialCrc32 = 0x04C11DB7;
+constexpr uint32_t kPolynomialCrc32c = 0x1EDC6F41;
+
+// Reflected x^n mod P for the 32-bit polynomial, as required to shift CRC32
+// register with carry-less multiplication followed by crc32 instruction.
+constexpr uint32_t Crc32ShiftConstant(uint32_t polynomial, uint64_t n) {
+  uint32_t value = 1;
+  for (uint64_t i = 0; i < n; ++i) {
+    value = (value & 0x80000000u) ? (value << 1) ^ polynomial : value << 1;
+  }
+  uint32_t reverse = 0;
+  for (size_t i = 0; i < 32; ++i) {
+    if (value & (1u << i)) {
+      reverse |= 1u << (31 - i);
+    }
+  }
+  return reverse;
+}
+
+}  // namespace detail
+
+#if defined(HASHLIB_HW_X86_64)
+
+namespace detail {
+
+// Register state enabled by the operating system.
+inline uint64_t ReadXcr0() noexcept {
+#if defined(_MSC_VER)
+  return _xgetbv(0);
+#else
+  uint32_t eax = 0, edx = 0;
+  __asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+}  // namespace detail
+
+inline const CpuFeatures& GetCpuFeatures() noexcept {
+  static const CpuFeatures features = [] {
+    CpuFeatures result;
+    unsigned int ecx = 0;
+    unsigned int ebx_7 = 0;
+#if defined(_MSC_VER)
+    int info[4] = {0, 0, 0, 0};
+    __cpuid(info, 1);
+    ecx = static_cast<unsigned int>(info[2]);
+    __cpuidex(info, 7, 0);
+    ebx_7 = static_cast<unsigned int>(info[1]);
+#else
+    unsigned int eax = 0, ebx = 0, edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+      return result;
+    }
+    unsigned int ecx_7 = 0;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx_7, &ecx_7, &edx)) {
+      ebx_7 = 0;
+    }
+#endif
+    const bool ssse3 = ecx & (1u << 9);
+    const bool sse41 = ecx & (1u << 19);
+    result.crc32c = ecx & (1u << 20);
+    result.clmul = (ecx & (1u << 1)) && ssse3 && sse41;
+    // Vector registers have to be enabled by the operating system as well.
+    const bool osxsave = ecx & (1u << 27);
+    const uint64_t xcr0 = osxsave ? detail::ReadXcr0() : 0;
+    result.avx2 = (ecx & (1u << 28)) && (xcr0 & 0x6) == 0x6 &&
+                  (ebx_7 & (1u << 5));
+    result.avx512 = result.avx2 && (xcr0 & 0xE6) == 0xE6 &&
+                    (ebx_7 & (1u << 16)) && (ebx_7 & (1u << 30));
+    return result;
+  }();
+  return features;
+}
+
+namespace detail {
+
+inline uint64_t Load64(const uint8_t* data) noexcept {
+  uint64_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+HASHLIB_TARGET("sse4.2")
+inline uint32_t Crc32cBytes(uint32_t crc, const uint8_t* data,
+                            size_t size) noexcept {
+  uint64_t crc_64 = crc;
+  for (; size >= 8; size -= 8, data += 8) {
+    crc_64 = _mm_crc32_u64(crc_64, Load64(data));
+  }
+  crc = static_cast<uint32_t>(crc_64);
+  for (; size > 0; --size, ++data) {
+    crc = _mm_crc32_u8(crc, *data);
+  }
+  return crc;
+}
+
+// Multiply register by x^(8 * distance) mod P using precomputed constant.
+HASHLIB_TARGET("sse4.2,pclmul")
+inline uint32_t Crc32cShift(uint64_t crc, uint32_t constant) noexcept {
+  const __m128i product =
+      _mm_clmulepi64_si128(_mm_cvtsi64_si128(static_cast<int64_t>(crc)),
+                           _mm_cvtsi32_si128(static_cast<int>(constant)), 0);
+  return static_cast<uint32_t>(
+      _mm_crc32_u64(0, static_cast<uint64_t>(_mm_cvtsi128_si64(product))));
+}
+
+// Crc32 instruction has latency of 3 cycles, but can be issued every cycle.
+// Process 3 independent streams and merge them with carry-less
+// multiplication.
+template <size_t block>
+HASHLIB_TARGET("sse4.2,pclmul")
+inline uint32_t Crc32cInterleaved(uint32_t crc, const uint8_t** data,
+                                  size_t* size) noexcept {
+  static constexpr uint32_t shift_1 =
+      Crc32ShiftConstant(kPolynomialCrc32c, 8 * block - 33);
+  static constexpr uint32_t shift_2 =
+      Crc32ShiftConstant(kPolynomialCrc32c, 16 * block - 33);
+  const uint8_t* ptr = *data;
+  size_t bytes_left = *size;
+  while (bytes_left >= 3 * block) {
+    uint64_t crc_0 = crc;
+    uint64_t crc_1 = 0;
+    uint64_t crc_2 = 0;
+    for (size_t i = 0; i < block; i += 8) {
+      crc_0 = _mm_crc32_u64(crc_0, Load64(ptr + i));
+      crc_1 = _mm_crc32_u64(crc_1, Load64(ptr + block + i));
+      crc_2 = _mm_crc32_u64(crc_2, Load64(ptr + 2 * block + i));
+    }
+    crc = Crc32cShift(crc_0, shift_2) ^ Crc32cShift(crc_1, shift_1) ^
+          static_cast<uint32_t>(crc_2);
+    ptr += 3 * block;
+    bytes_left -= 3 * block;
+  }
+  *data = ptr;
+  *size = bytes_left;
+  return crc;
+}
+
+HASHLIB_TARGET("sse4.2")
+inline void Crc32cLanes(uint32_t crc[kLanes],
+                        const uint8_t* const data[kLanes],
+                        size_t size) noexcept {
+  uint64_t crc_0 = crc[0];
+  uint64_t crc_1 = crc[1];
+  uint64_t crc_2 = crc[2];
+  uint64_t crc_3 = crc[3];
+  for (size_t i = 0; i < size; i += 8) {
+    crc_0 = _mm_crc32_u64(crc_0, Load64(data[0] + i));
+    crc_1 = _mm_crc32_u64(crc_1, Load64(data[1] + i));
+    crc_2 = _mm_crc32_u64(crc_2, Load64(data[2] + i));
+    crc_3 = _mm_crc32_u64(crc_3, Load64(data[3] + i));
+  }
+  crc[0] = static_cast<uint32_t>(crc_0);
+  crc[1] = static_cast<uint32_t>(crc_1);
+  crc[2] = static_cast<uint32_t>(crc_2);
+  crc[3] = static_cast<uint32_t>(crc_3);
+}
+
+// Reflected registers are indexed from the last byte of the word by the
+// first slice. Normal registers consume words with swapped bytes, which
+// reverses order of the slices.
+template <bool reflected>
+HASHLIB_TARGET("avx2")
+inline __m256i GatherStep256(__m256i words, __m256i crc,
+                             const int* table) noexcept {
+  const __m256i mask = _mm256_set1_epi32(0xFF);
+  if (!reflected) {
+    words = _mm256_shuffle_epi8(
+        words, _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14,
+                                13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8,
+                                15, 14, 13, 12));
+  }
+  words = _mm256_xor_si256(words, crc);
+  const __m256i byte_0 = _mm256_and_si256(words, mask);
+  const __m256i byte_1 = _mm256_and_si256(_mm256_srli_epi32(words, 8), mask);
+  const __m256i byte_2 = _mm256_and_si256(_mm256_srli_epi32(words, 16), mask);
+  const __m256i byte_3 = _mm256_srli_epi32(words, 24);
+  const __m256i lo = _mm256_xor_si256(
+      _mm256_i32gather_epi32(table, reflected ? byte_3 : byte_0, 4),
+      _mm256_i32gather_epi32(table + 256, reflected ? byte_2 : byte_1, 4));
+  const __m256i hi = _mm256_xor_si256(
+      _mm256_i32gather_epi32(table + 512, reflected ? byte_1 : byte_2, 4),
+      _mm256_i32gather_epi32(table + 768, reflected ? byte_0 : byte_3, 4));
+  return _mm256_xor_si256(lo, hi);
+}
+
+// Load 32-bit words from 8 data pointers.
+HASHLIB_TARGET("avx2")
+inline __m256i LoadLanes256(__m256i addresses_lo,
+                            __m256i addresses_hi) noexcept {
+  return _mm256_inserti128_si256(
+      _mm256_castsi128_si256(
+          _mm256_i64gather_epi32(static_cast<const int*>(nullptr),
+                                 addresses_lo, 1)),
+      _mm256_i64gather_epi32(static_cast<const int*>(nullptr), addresses_hi,
+                             1),
+      1);
+}
+
+template <bool reflected>
+HASHLIB_TARGET("avx2")
+inline void GatherLanes256(uint32_t crc[kGatherLanes],
+                           const uint8_t* const data[kGatherLanes],
+                           size_t size,
+                           const uint32_t (*lookup)[256]) noexcept {
+  const int* table = reinterpret_cast<const int*>(lookup);
+  const auto* pointers = reinterpret_cast<const __m256i*>(data);
+  __m256i addresses[4] = {
+      _mm256_loadu_si256(pointers), _mm256_loadu_si256(pointers + 1),
+      _mm256_loadu_si256(pointers + 2), _mm256_loadu_si256(pointers + 3)};
+  // Two independent vectors hide latency of the gathers.
+  __m256i crc_0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(crc));
+  __m256i crc_1 =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(crc + 8));
+  const __m256i step = _mm256_set1_epi64x(sizeof(uint32_t));
+  for (size_t i = 0; i < size; i += sizeof(uint32_t)) {
+    crc_0 = GatherStep256<reflected>(LoadLanes256(addresses[0], addresses[1]),
+                                     crc_0, table);
+    crc_1 = GatherStep256<reflected>(LoadLanes256(addresses[2], addresses[3]),
+                                     crc_1, table);
+    for (__m256i& address : addresses) {
+      address = _mm256_add_epi64(address, step);
+    }
+  }
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(crc), crc_0);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(crc + 8), crc_1);
+}
+
+template <bool reflected>
+HASHLIB_TARGET("avx512f,avx512bw")
+inline void GatherLanes512(uint32_t crc[kGatherLanes],
+                           const uint8_t* const data[kGatherLanes],
+                           size_t size,
+                           const uint32_t (*lookup)[256]) noexcept {
+  const int* table = reinterpret_cast<const int*>(lookup);
+  __m512i addresses_lo = _mm512_loadu_si512(data);
+  __m512i addresses_hi = _mm512_loadu_si512(data + 8);
+  __m512i state = _mm512_loadu_si512(crc);
+  const __m512i mask = _mm512_set1_epi32(0xFF);
+  const __m512i swap = _mm512_set4_epi32(0x0C0D0E0F, 0x08090A0B, 0x04050607,
+                                         0x00010203);
+  const __m512i step = _mm512_set1_epi64(sizeof(uint32_t));
+  // Masked forms with an explicit zero source, the unmasked ones (and
+  // zero extension) pass an undefined register, which makes GCC warn about
+  // uninitialized use.
+  const __m256i zero_256 = _mm256_setzero_si256();
+  const __m512i zero = _mm512_setzero_si512();
+  const __mmask8 all_8 = 0xFF;
+  const __mmask16 all = 0xFFFF;
+  for (size_t i = 0; i < size; i += sizeof(uint32_t)) {
+    const __m256i words_lo = _mm512_mask_i64gather_epi32(
+        zero_256, all_8, addresses_lo, nullptr, 1);
+    const __m256i words_hi = _mm512_mask_i64gather_epi32(
+        zero_256, all_8, addresses_hi, nullptr, 1);
+    __m512i words = _mm512_maskz_inserti64x4(
+        all_8, _mm512_maskz_inserti64x4(all_8, zero, words_lo, 0), words_hi,
+        1);
+    if (!reflected) {
+      words = _mm512_shuffle_epi8(words, swap);
+    }
+    words = _mm512_xor_si512(words, state);
+    const __m512i byte_0 = _mm512_and_si512(words, mask);
+    const __m512i byte_1 =
+        _mm512_and_si512(_mm512_maskz_srli_epi32(all, words, 8), mask);
+    const __m512i byte_2 =
+        _mm512_and_si512(_mm512_maskz_srli_epi32(all, words, 16), mask);
+    const __m512i byte_3 = _mm512_maskz_srli_epi32(all, words, 24);
+    const __m512i lo = _mm512_xor_si512(
+        _mm512_mask_i32gather_epi32(zero, all, reflected ? byte_3 : byte_0,
+                                    table, 4),
+        _mm512_mask_i32gather_epi32(zero, all, reflected ? byte_2 : byte_1,
+                                    table + 256, 4));
+    const __m512i hi = _mm512_xor_si512(
+        _mm512_mask_i32gather_epi32(zero, all, reflected ? byte_1 : byte_2,
+                                    table + 512, 4),
+        _mm512_mask_i32gather_epi32(zero, all, reflected ? byte_0 : byte_3,
+                                    table + 768, 4));
+    state = _mm512_xor_si512(lo, hi);
+    addresses_lo = _mm512_add_epi64(addresses_lo, step);
+    addresses_hi = _mm512_add_epi64(addresses_hi, step);
+  }
+  _mm512_storeu_si512(crc, state);
+}
+
+HASHLIB_TARGET("pclmul,ssse3")
+inline __m128i Fold(__m128i value, __m128i constants) noexcept {
+  return _mm_xor_si128(_mm_clmulepi64_si128(value, constants, 0x00),
+                       _mm_clmulepi64_si128(value, constants, 0x11));
+}
+
+// Reflected data is loaded as is. Otherwise reverse bytes so the first byte
+// of data contains highest order coefficients.
+template <bool reflected>
+HASHLIB_TARGET("pclmul,ssse3")
+inline __m128i LoadBlock(const uint8_t* data) noexcept {
+  const __m128i block =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+  if (reflected) {
+    return block;
+  }
+  return _mm_shuffle_epi8(block, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9,
+                                              10, 11, 12, 13, 14, 15));
+}
+
+template <bool reflected>
+HASHLIB_TARGET("pclmul,ssse3")
+inline size_t ClmulFold(uint64_t crc, size_t bits,
+                        const FoldConstants& constants, const uint8_t* data,
+                        size_t size, uint8_t remainder[16]) noexcept {
+  if (size < 64) {
+    return 0;
+  }
+  const __m128i fold_512 =
+      _mm_set_epi64x(static_cast<int64_t>(constants.fold_512_hi),
+                     static_cast<int64_t>(constants.fold_512_lo));
+  const __m128i fold_128 =
+      _mm_set_epi64x(static_cast<int64_t>(constants.fold_128_hi),
+                     static_cast<int64_t>(constants.fold_128_lo));
+  const size_t consumed = size & ~static_cast<size_t>(15);
+  size_t bytes_left = consumed;
+
+  __m128i x0 = LoadBlock<reflected>(data);
+  __m128i x1 = LoadBlock<reflected>(data + 16);
+  __m128i x2 = LoadBlock<reflected>(data + 32);
+  __m128i x3 = LoadBlock<reflected>(data + 48);
+  // Initial register is aligned with the first bits of data.
+  if (reflected) {
+    x0 = _mm_xor_si128(x0, _mm_cvtsi64_si128(static_cast<int64_t>(crc)));
+  } else {
+    x0 = _mm_xor_si128(
+        x0, _mm_set_epi64x(static_cast<int64_t>(crc << (64 - bits)), 0));
+  }
+  data += 64;
+  bytes_left -= 64;
+
+  while (bytes_left >= 64) {
+    x0 = _mm_xor_si128(Fold(x0, fold_512), LoadBlock<reflected>(data));
+    x1 = _mm_xor_si128(Fold(x1, fold_512), LoadBlock<reflected>(data + 16));
+    x2 = _mm_xor_si128(Fold(x2, fold_512), LoadBlock<reflected>(data + 32));
+    x3 = _mm_xor_si128(Fold(x3, fold_512), LoadBlock<reflected>(data + 48));
+    data += 64;
+    bytes_left -= 64;
+  }
+  x1 = _mm_xor_si128(Fold(x0, fold_128), x1);
+  x2 = _mm_xor_si128(Fold(x1, fold_128), x2);
+  x3 = _mm_xor_si128(Fold(x2, fold_128), x3);
+  while (bytes_left >= 16) {
+    x3 = _mm_xor_si128(Fold(x3, fold_128), LoadBlock<reflected>(data));
+    data += 16;
+    bytes_left -= 16;
+  }
+  // Reverse bytes back (if required) to restore original data ordering.
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(remainder),
+                   LoadBlock<reflected>(reinterpret_cast<uint8_t*>(&x3)));
+  return consumed;
+}
+
+}  // namespace detail
+
+// There is no dedicated CRC32 instruction on x86.
+inline uint32_t Crc32(uint32_t crc, const uint8_t*, size_t) noexcept {
+  return crc;
+}
+
+inline uint32_t Crc32c(uint32_t crc, const uint8_t* data,
+                       size_t size) noexcept {
+  if (GetCpuFeatures().clmul) {
+    crc = detail::Crc32cInterleaved<1024>(crc, &data, &size);
+    crc = detail::Crc32cInterleaved<128>(crc, &data, &size);
+  }
+  return detail::Crc32cBytes(crc, data, size);
+}
+
+inline void Crc32Lanes(uint32_t*, const uint8_t* const*, size_t) noexcept {}
+
+inline void Crc32cLanes(uint32_t crc[kLanes],
+                        const uint8_t* const data[kLanes],
+                        size_t size) noexcept {
+  detail::Crc32cLanes(crc, data, size);
+}
+
+inline void GatherLanes(uint32_t crc[kGatherLanes],
+                        const uint8_t* const data[kGatherLanes], size_t size,
+                        bool reflected,
+                        const uint32_t (*lookup)[256]) noexcept {
+  if (GetCpuFeatures().avx512) {
+    if (reflected) {
+      detail::GatherLanes512<true>(crc, data, size, lookup);
+    } else {
+      detail::GatherLanes512<false>(crc, data, size, lookup);
+    }
+  } else if (reflected) {
+    detail::GatherLanes256<true>(crc, data, size, lookup);
+  } else {
+    detail::GatherLanes256<false>(crc, data, size, lookup);
+  }
+}
+
+inline size_t ClmulFold(uint64_t crc, size_t bits, bool reflected,
+                        const FoldConstants& constants, const uint8_t* data,
+                        size_t size, uint8_t remainder[16]) noexcept {
+  if (reflected) {
+    return detail::ClmulFold<true>(crc, bits, constants, data, size,
+                                   remainder);
+  }
+  return detail::ClmulFold<false>(crc, bits, constants, data, size, remainder);
+}
+
+// SSE2 is part of x86-64, no feature check is needed.
+inline void CopyStreaming(uint8_t* dst, const uint8_t* src,
+                          size_t size) noexcept {
+  // Align the destination, streaming stores require 16 byte alignment.
+  const size_t head = std::min(
+      size, (16 - reinterpret_cast<uintptr_t>(dst) % 16) % 16);
+  std::memcpy(dst, src, head);
+  dst += head;
+  src += head;
+  size -= head;
+  for (; size >= 64; size -= 64, dst += 64, src += 64) {
+    const __m128i block_1 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    const __m128i block_2 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+    const __m128i block_3 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+    const __m128i block_4 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 48));
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst), block_1);
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 16), block_2);
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 32), block_3);
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 48), block_4);
+  }
+  // Make the streamed data visible before any following store.
+  _mm_sfence();
+  std::memcpy(dst, src, size);
+}
+
+#elif defined(HASHLIB_HW_AARCH64)
+
+inline const CpuFeatures& GetCpuFeatures() noexcept {
+  static const CpuFeatures features = [] {
+    CpuFeatures result;
+#if defined(__linux__)
+    const unsigned long hwcap = getauxval(AT_HWCAP);
+    result.crc32 = hwcap & HWCAP_CRC32;
+    result.clmul = hwcap & HWCAP_PMULL;
+#elif defined(__APPLE__)
+    // Every Apple ARMv8 CPU supports both extensions.
+    result.crc32 = true;
+    result.clmul = true;
+#else
+#if defined(__ARM_FEATURE_CRC32)
+    result.crc32 = true;
+#endif
+#if defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES)
+    result.clmul = true;
+#endif
+#endif
+    result.crc32c = result.crc32;
+    return result;
+  }();
+  return features;
+}
+
+namespace detail {
+
+inline uint64_t Load64(const uint8_t* data) noexcept {
+  uint64_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+template <bool castagnoli>
+HASHLIB_TARGET_ARM_CRC inline uint32_t Crc32Word(uint32_t crc,
+                                                 uint64_t value) noexcept {
+  return castagnoli ? __crc32cd(crc, value) : __crc32d(crc, value);
+}
+
+template <bool castagnoli>
+HASHLIB_TARGET_ARM_CRC inline uint32_t Crc32Bytes(uint32_t crc,
+                                                  const uint8_t* data,
+                                                  size_t size) noexcept {
+  for (; size >= 8; size -= 8, data += 8) {
+    crc = Crc32Word<castagnoli>(crc, Load64(data));
+  }
+  for (; size > 0; --size, ++data) {
+    crc = castagnoli ? __crc32cb(crc, *data) : __crc32b(crc, *data);
+  }
+  return crc;
+}
+
+// Multiply register by x^(8 * distance) mod P using precomputed constant.
+template <bool castagnoli>
+HASHLIB_TARGET_ARM_CRC_PMULL inline uint32_t Crc32Shift(
+    uint32_t crc, uint32_t constant) noexcept {
+  const poly128_t product = vmull_p64(static_cast<poly64_t>(crc),
+                                      static_cast<poly64_t>(constant));
+  return Crc32Word<castagnoli>(
+      0, vgetq_lane_u64(vreinterpretq_u64_p128(product), 0));
+}
+
+// Crc32 instructions are pipelined. Process 3 independent streams and merge
+// them with carry-less multiplication.
+template <bool castagnoli, size_t block>
+HASHLIB_TARGET_ARM_CRC_PMULL inline uint32_t Crc32Interleaved(
+    uint32_t crc, const uint8_t** data, size_t* size) noexcept {
+  static constexpr uint32_t polynomial =
+      castagnoli ? kPolynomialCrc32c : kPolynomialCrc32;
+  static constexpr uint32_t shift_1 =
+      Crc32ShiftConstant(polynomial, 8 * block - 33);
+  static constexpr uint32_t shift_2 =
+      Crc32ShiftConstant(polynomial, 16 * block - 33);
+  const uint8_t* ptr = *data;
+  size_t bytes_left = *size;
+  while (bytes_left >= 3 * block) {
+    uint32_t crc_0 = crc;
+    uint32_t crc_1 = 0;
+    uint32_t crc_2 = 0;
+    for (size_t i = 0; i < block; i += 8) {
+      crc_0 = Crc32Word<castagnoli>(crc_0, Load64(ptr + i));
+      crc_1 = Crc32Word<castagnoli>(crc_1, Load64(ptr + block + i));
+      crc_2 = Crc32Word<castagnoli>(crc_2, Load64(ptr + 2 * block + i));
+    }
+    crc = Crc32Shift<castagnoli>(crc_0, shift_2) ^
+          Crc32Shift<castagnoli>(crc_1, shift_1) ^ crc_2;
+    ptr += 3 * block;
+    bytes_left -= 3 * block;
+  }
+  *data = ptr;
+  *size = bytes_left;
+  return crc;
+}
+
+template <bool castagnoli>
+inline uint32_t Crc32Any(uint32_t crc, const uint8_t* data,
+                         size_t size) noexcept {
+  if (GetCpuFeatures().clmul) {
+    crc = Crc32Interleaved<castagnoli, 1024>(crc, &data, &size);
+    crc = Crc32Interleaved<castagnoli, 128>(crc, &data, &size);
+  }
+  return Crc32Bytes<castagnoli>(crc, data, size);
+}
+
+template <bool castagnoli>
+HASHLIB_TARGET_ARM_CRC inline void Crc32Lanes(
+    uint32_t crc[kLanes], const uint8_t* const data[kLanes],
+    size_t size) noexcept {
+  uint32_t crc_0 = crc[0];
+  uint32_t crc_1 = crc[1];
+  uint32_t crc_2 = crc[2];
+  uint32_t crc_3 = crc[3];
+  for (size_t i = 0; i < size; i += 8) {
+    crc_0 = Crc32Word<castagnoli>(crc_0, Load64(data[0] + i));
+    crc_1 = Crc32Word<castagnoli>(crc_1, Load64(data[1] + i));
+    crc_2 = Crc32Word<castagnoli>(crc_2, Load64(data[2] + i));
+    crc_3 = Crc32Word<castagnoli>(crc_3, Load64(data[3] + i));
+  }
+  crc[0] = crc_0;
+  crc[1] = crc_1;
+  crc[2] = crc_2;
+  crc[3] = crc_3;
+}
+
+HASHLIB_TARGET_ARM_PMULL
+inline uint64x2_t Fold(uint64x2_t value, uint64x2_t constants) noexcept {
+  const poly128_t lo =
+      vmull_p64(vgetq_lane_p64(vreinterpretq_p64_u64(value), 0),
+                vgetq_lane_p64(vreinterpretq_p64_u64(constants), 0));
+  const poly128_t hi = vmull_high_p64(vreinterpretq_p64_u64(value),
+                                      vreinterpretq_p64_u64(constants));
+  return veorq_u64(vreinterpretq_u64_p128(lo), vreinterpretq_u64_p128(hi));
+}
+
+// Reflected data is loaded as is. Otherwise reverse bytes so the first byte
+// of data contains highest order coefficients.
+template <bool reflected>
+HASHLIB_TARGET_ARM_PMULL inline uint64x2_t LoadBlock(
+    const uint8_t* data) noexcept {
+  const uint8x16_t block = vld1q_u8(data);
+  if (reflected) {
+    return vreinterpretq_u64_u8(block);
+  }
+  const uint8x16_t swapped = vrev64q_u8(block);
+  return vreinterpretq_u64_u8(vextq_u8(swapped, swapped, 8));
+}
+
+template <bool reflected>
+HASHLIB_TARGET_ARM_PMULL inline size_t ClmulFold(
+    uint64_t crc, size_t bits, const FoldConstants& constants,
+    const uint8_t* data, size_t size, uint8_t remainder[16]) noexcept {
+  if (size < 64) {
+    return 0;
+  }
+  const uint64x2_t fold_512 = vcombine_u64(vcreate_u64(constants.fold_512_lo),
+                                           vcreate_u64(constants.fold_512_hi));
+  const uint64x2_t fold_128 = vcombine_u64(vcreate_u64(constants.fold_128_lo),
+                                           vcreate_u64(constants.fold_128_hi));
+  const size_t consumed = size & ~static_cast<size_t>(15);
+  size_t bytes_left = consumed;
+
+  uint64x2_t x0 = LoadBlock<reflected>(data);
+  uint64x2_t x1 = LoadBlock<reflected>(data + 16);
+  uint64x2_t x2 = LoadBlock<reflected>(data + 32);
+  uint64x2_t x3 = LoadBlock<reflected>(data + 48);
+  // Initial register is aligned with the first bits of data.
+  if (reflected) {
+    x0 = veorq_u64(x0, vcombine_u64(vcreate_u64(crc), vcreate_u64(0)));
+  } else {
+    x0 = veorq_u64(
+        x0, vcombine_u64(vcreate_u64(0), vcreate_u64(crc << (64 - bits))));
+  }
+  data += 64;
+  bytes_left -= 64;
+
+  while (bytes_left >= 64) {
+    x0 = veorq_u64(Fold(x0, fold_512), LoadBlock<reflected>(data));
+    x1 = veorq_u64(Fold(x1, fold_512), LoadBlock<reflected>(data + 16));
+    x2 = veorq_u64(Fold(x2, fold_512), LoadBlock<reflected>(data + 32));
+    x3 = veorq_u64(Fold(x3, fold_512), LoadBlock<reflected>(data + 48));
+    data += 64;
+    bytes_left -= 64;
+  }
+  x1 = veorq_u64(Fold(x0, fold_128), x1);
+  x2 = veorq_u64(Fold(x1, fold_128), x2);
+  x3 = veorq_u64(Fold(x2, fold_128), x3);
+  while (bytes_left >= 16) {
+    x3 = veorq_u64(Fold(x3, fold_128), LoadBlock<reflected>(data));
+    data += 16;
+    bytes_left -= 16;
+  }
+  // Reverse bytes back (if required) to restore original data ordering.
+  uint8_t folded[16];
+  vst1q_u8(folded, vreinterpretq_u8_u64(x3));
+  vst1q_u8(remainder, vreinterpretq_u8_u64(LoadBlock<reflected>(folded)));
+  return consumed;
+}
+
+}  // namespace detail
+
+inline uint32_t Crc32(uint32_t crc, const uint8_t* data,
+                      size_t size) noexcept {
+  return detail::Crc32Any<false>(crc, data, size);
+}
+
+inline uint32_t Crc32c(uint32_t crc, const uint8_t* data,
+                       size_t size) noexcept {
+  return detail::Crc32Any<true>(crc, data, size);
+}
+
+inline void Crc32Lanes(uint32_t crc[kLanes], const uint8_t* const data[kLanes],
+                       size_t size) noexcept {
+  detail::Crc32Lanes<false>(crc, data, size);
+}
+
+inline void Crc32cLanes(uint32_t crc[kLanes],
+                        const uint8_t* const data[kLanes],
+                        size_t size) noexcept {
+  detail::Crc32Lanes<true>(crc, data, size);
+}
+
+// Gathers are not available in NEON.
+inline void GatherLanes(uint32_t*, const uint8_t* const*, size_t, bool,
+                        const uint32_t (*)[256]) noexcept {}
+
+inline size_t ClmulFold(uint64_t crc, size_t bits, bool reflected,
+                        const FoldConstants& constants, const uint8_t* data,
+                        size_t size, uint8_t remainder[16]) noexcept {
+  if (reflected) {
+    return detail::ClmulFold<true>(crc, bits, constants, data, size,
+                                   remainder);
+  }
+  return detail::ClmulFold<false>(crc, bits, constants, data, size, remainder);
+}
+
+// Non-temporal pair stores are not exposed by the intrinsics.
+inline void CopyStreaming(uint8_t* dst, const uint8_t* src,
+                          size_t size) noexcept {
+  std::memcpy(dst, src, size);
+}
+
+#else
+
+// No hardware acceleration available for this architecture.
+inline const CpuFeatures& GetCpuFeatures() noexcept {
+  static const CpuFeatures features;
+  return features;
+}
+
+inline uint32_t Crc32(uint32_t crc, const uint8_t*, size_t) noexcept {
+  return crc;
+}
+
+inline uint32_t Crc32c(uint32_t crc, const uint8_t*, size_t) noexcept {
+  return crc;
+}
+
+inline void Crc32Lanes(uint32_t*, const uint8_t* const*, size_t) noexcept {}
+
+inline void Crc32cLanes(uint32_t*, const uint8_t* const*, size_t) noexcept {}
+
+inline void GatherLanes(uint32_t*, const uint8_t* const*, size_t, bool,
+                        const uint32_t (*)[256]) noexcept {}
+
+inline size_t ClmulFold(uint64_t, size_t, bool, const FoldConstants&,
+                        const uint8_t*, size_t, uint8_t*) noexcept {
+  return 0;
+}
+
+inline void CopyStreaming(uint8_t* dst, const uint8_t* src,
+                          size_t size) noexcept {
+  std::memcpy(dst, src, size);
+}
+
+#endif
+
+}  // namespace hw
+}  // namespace hash
+
+#endif  // CRC_HW_H_
@@ -0,0 +1,180 @@
+#ifndef CRC_PLACEMENT_H_
+#define CRC_PLACEMENT_H_
+
+#include <algorithm>  // std::max
+#include <cstdint>    // uint8_t / uint32_t
+#include <cstdlib>    // std::aligned_alloc / std::free
+#include <cstring>    // std::memcpy
+#include <map>        // std::map
+#include <memory>     // std::unique_ptr
+#include <mutex>      // std::mutex
+#include <new>        // std::bad_alloc
+#include <tuple>      // std::tuple
+#include <vector>     // std::vector
+
+#if defined(__linux__)
+#define HASHLIB_NUMA_LINUX 1
+#include <sched.h>     // getcpu
+#include <sys/mman.h>  // madvise
+#endif
+
+#include "crc.h"
+
+namespace hash {
+
+// Placement of the lookup tables used by CrcEngine.
+enum CrcTablePlacement {
+  // Single table shared by all threads.
+  TABLE_SHARED,
+  // Copy of the table on every NUMA node, used by the threads running there.
+  TABLE_NODE_LOCAL,
+  // Node local copies packed into transparent huge pages, so tables of all
+  // CRCs on the node are covered by a single TLB entry.
+  TABLE_NODE_LOCAL_HUGE_PAGES
+};
+
+namespace detail {
+
+constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+// Calls using the cached node of the thread before it is queried again, in
+// case the thread migrated to another node.
+constexpr uint32_t kNodeRefreshCalls = 1024;
+
+// NUMA node of the CPU running the calling thread, 0 if unknown.
+inline unsigned CurrentNode() noexcept {
+#if defined(HASHLIB_NUMA_LINUX) && defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 29)
+  unsigned cpu = 0;
+  unsigned node = 0;
+  if (getcpu(&cpu, &node) == 0) {
+    return node;
+  }
+#endif
+  return 0;
+}
+
+// CurrentNode() cached per thread.
+inline unsigned ThreadNode() noexcept {
+  thread_local unsigned node = 0;
+  thread_local uint32_t calls = 0;
+  if (calls == 0) {
+    node = CurrentNode();
+    calls = kNodeRefreshCalls;
+  }
+  --calls;
+  return node;
+}
+
+// Memory of node local tables, never released. Chunks are allocated and
+// written by a thread of the node, so the first touch policy of the kernel
+// places them on that node.
+class TableArena {
+ public:
+  explicit TableArena(bool huge_pages) : huge_pages_(huge_pages) {}
+  TableArena(const TableArena&) = delete;
+  TableArena& operator=(const TableArena&) = delete;
+
+  // Uninitialized memory aligned to the cache line.
+  void* Allocate(size_t size) {
+    size = (size + 63) / 64 * 64;
+    if (size > left_) {
+      const size_t chunk = std::max(size, kHugePageSize);
+      // Huge page alignment lets the kernel back the chunk by a huge page.
+      void* memory =
+          std::aligned_alloc((huge_pages_) ? kHugePageSize : 64, chunk);
+      if (memory == nullptr) {
+        throw std::bad_alloc();
+      }
+#if defined(HASHLIB_NUMA_LINUX) && defined(MADV_HUGEPAGE)
+      if (huge_pages_) {
+        madvise(memory, chunk, MADV_HUGEPAGE);
+      }
+#endif
+      chunks_.emplace_back(static_cast<uint8_t*>(memory));
+      next_ = chunks_.back().get();
+      left_ = chunk;
+    }
+    void* result = next_;
+    next_ += size;
+    left_ -= size;
+    return result;
+  }
+
+ private:
+  struct Free {
+    void operator()(uint8_t* memory) const noexcept { std::free(memory); }
+  };
+
+  bool huge_pages_;
+  std::vector<std::unique_ptr<uint8_t, Free>> chunks_;
+  uint8_t* next_ = nullptr;
+  size_t left_ = 0;
+};
+
+// Memory for a node local table of 'size' bytes from the arena of 'node',
+// shared by tables of all register types.
+inline void* AllocateNodeLocal(unsigned node, bool huge_pages, size_t size) {
+  static std::mutex mutex;
+  static std::map<std::tuple<unsigned, bool>, std::unique_ptr<TableArena>>
+      arenas;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& arena = arenas[std::make_tuple(node, huge_pages)];
+  if (!arena) {
+    arena.reset(new TableArena(huge_pages));
+  }
+  return arena->Allocate(size);
+}
+
+// Copy of 'shared' table on the node of the calling thread, created on first
+// use by that node. Returns 'shared' for TABLE_SHARED placement, or if the
+// copy can not be allocated.
+template <typename T>
+const CrcTable<T>* NodeLocalTable(const CrcTable<T>* shared,
+                                  CrcTablePlacement placement) noexcept {
+  if (placement == TABLE_SHARED) {
+    return shared;
+  }
+  const unsigned node = ThreadNode();
+  // Threads mostly use the same table, skip the lock then.
+  struct Cached {
+    const CrcTable<T>* shared = nullptr;
+    CrcTablePlacement placement = TABLE_SHARED;
+    unsigned node = 0;
+    const CrcTable<T>* local = nullptr;
+  };
+  thread_local Cached cached;
+  if (cached.shared == shared && cached.placement == placement &&
+      cached.node == node) {
+    return cached.local;
+  }
+  const bool huge_pages = placement == TABLE_NODE_LOCAL_HUGE_PAGES;
+  static std::mutex mutex;
+  static std::map<std::tuple<const CrcTable<T>*, unsigned, bool>,
+                  std::unique_ptr<const CrcTable<T>>>
+      tables;
+  const CrcTable<T>* local = shared;
+  try {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& table = tables[std::make_tuple(shared, node, huge_pages)];
+    if (!table) {
+      void* lookup =
+          AllocateNodeLocal(node, huge_pages, shared->footprint());
+      std::memcpy(lookup, shared->lookup, shared->footprint());
+      table.reset(new CrcTable<T>{static_cast<const T(*)[256]>(lookup),
+                                  shared->slices, shared->fold,
+                                  shared->polynomial});
+    }
+    local = table.get();
+  } catch (...) {
+    // Shared table is correct as well, only slower to reach.
+    return shared;
+  }
+  cached = {shared, placement, node, local};
+  return local;
+}
+
+}  // namespace detail
+
+}  // namespace hash
+
+#endif  // CRC_PLACEMENT_H_
@@ -0,0 +1,247 @@
+#ifndef CRC_STREAM_H_
+#define CRC_STREAM_H_
+
+// Coroutine interface requires C++20, the header is empty otherwise.
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define HASHLIB_COROUTINES 1
+
+#include <algorithm>    // std::min
+#include <atomic>       // std::atomic
+#include <coroutine>    // std::coroutine_handle / std::suspend_always
+#include <cstdint>      // uint8_t / uint64_t
+#include <exception>    // std::exception_ptr
+#include <thread>       // std::this_thread::yield
+#include <utility>      // std::exchange
+#include <vector>       // std::vector
+
+#include "crc.h"
+
+namespace hash {
+
+// Lazily started coroutine returning a CRC value, resumed by co_await. The
+// awaiting coroutine continues on the thread which completed the task.
+template <typename T>
+class CrcTask {
+ public:
+  struct promise_type {
+    struct FinalAwaiter {
+      bool await_ready() const noexcept { return false; }
+      std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<promise_type> handle) noexcept {
+        return handle.promise().continuation;
+      }
+      void await_resume() const noexcept {}
+    };
+
+    CrcTask get_return_object() noexcept {
+      return CrcTask(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void return_value(T result) noexcept { value = result; }
+    void unhandled_exception() noexcept { error = std::current_exception(); }
+
+    T value = 0;
+    std::exception_ptr error;
+    std::coroutine_handle<> continuation = std::noop_coroutine();
+  };
+
+  CrcTask(CrcTask&& other) noexcept
+      : handle_(std::exchange(other.handle_, nullptr)) {}
+  CrcTask(const CrcTask&) = delete;
+  CrcTask& operator=(const CrcTask&) = delete;
+  ~CrcTask() {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  bool await_ready() const noexcept { return false; }
+  std::coroutine_handle<> await_suspend(
+      std::coroutine_handle<> awaiting) noexcept {
+    handle_.promise().continuation = awaiting;
+    return handle_;
+  }
+  // Rethrows exception of the source.
+  T await_resume() const {
+    if (handle_.promise().error) {
+      std::rethrow_exception(handle_.promise().error);
+    }
+    return handle_.promise().value;
+  }
+
+ private:
+  explicit CrcTask(std::coroutine_handle<promise_type> handle) noexcept
+      : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+// CRC as a stage of a coroutine pipeline. Chunks of 'threshold' bytes and
+// more are split into parts consumed concurrently by 'pool', while the
+// awaiting coroutine is suspended, then joined by Combine(). Shorter chunks
+// are consumed inline. 'Pool' has to provide size() and Submit(task), e.g.
+// ThreadPool or WorkStealingPool.
+template <typename T, typename Pool>
+class CrcStream {
+ public:
+  CrcStream() = delete;
+  CrcStream(const OptionsCrc& options, Pool& pool,
+            size_t threshold = kParallelThreshold);
+  ~CrcStream() = default;
+
+  // Consume chunks of 'source' until it ends, then return CRC of all data
+  // consumed by the stream so far. 'source.Next()' has to return awaitable
+  // CrcBuffer with the next chunk, which stays valid until the following
+  // Next() call. Empty chunk ends the source. The stream and the source have
+  // to outlive the task.
+  template <typename Source>
+  CrcTask<T> Consume(Source& source);
+
+  // Retrieve CRC value of all consumed data.
+  T crc() const noexcept;
+  // Reset CRC value to initial one.
+  void reset() noexcept;
+
+ private:
+  // Offloads parts of a chunk to the pool and resumes the awaiting coroutine
+  // on the worker, which finished the last part.
+  class Offload;
+
+  // Join CRC of 'size' bytes following all consumed data.
+  void Append(T crc, uint64_t size) noexcept;
+
+  Pool& pool_;
+  size_t threshold_;
+  // Short chunks consumed since the last offloaded chunk.
+  Crc<T> tail_;
+  uint64_t tail_size_ = 0;
+  // CRC of data preceding the tail.
+  T crc_;
+};
+
+template <typename T, typename Pool>
+class CrcStream<T, Pool>::Offload {
+ public:
+  Offload(const Crc<T>& initial, Pool& pool, const uint8_t* data, size_t size)
+      : initial_(initial),
+        pool_(pool),
+        data_(data),
+        part_size_(size / std::min<size_t>(pool.size() + 1,
+                                           std::max<size_t>(
+                                               1, size / kMinParallelChunk))),
+        results_((size + part_size_ - 1) / part_size_),
+        size_(size) {}
+
+  bool await_ready() const noexcept { return false; }
+  bool await_suspend(std::coroutine_handle<> awaiting) {
+    // Extra count held until all parts are submitted, so no worker can
+    // resume the coroutine while this function still uses the awaiter.
+    remaining_.store(results_.size() + 1, std::memory_order_relaxed);
+    size_t submitted = 0;
+    try {
+      for (; submitted < results_.size(); ++submitted) {
+        pool_.Submit([this, i = submitted, awaiting] {
+          const size_t offset = i * part_size_;
+          Crc<T> part(initial_);
+          part.Consume(data_ + offset, std::min(part_size_, size_ - offset));
+          results_[i] = part.crc();
+          if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            awaiting.resume();
+          }
+        });
+      }
+    } catch (...) {
+      // Submitted parts still use the awaiter, wait for them before the
+      // exception resumes the coroutine. The extra count stays held, so
+      // none of them resumes it.
+      remaining_.fetch_sub(results_.size() - submitted,
+                           std::memory_order_acq_rel);
+      while (remaining_.load(std::memory_order_acquire) != 1) {
+        std::this_thread::yield();
+      }
+      throw;
+    }
+    // Resume immediately if all parts are already done.
+    return remaining_.fetch_sub(1, std::memory_order_acq_rel) != 1;
+  }
+  // CRC values of the parts, all of 'part_size()' bytes except the last.
+  const std::vector<T>& await_resume() const noexcept { return results_; }
+  size_t part_size() const noexcept { return part_size_; }
+
+ private:
+  const Crc<T>& initial_;
+  Pool& pool_;
+  const uint8_t* data_;
+  const size_t part_size_;
+  std::vector<T> results_;
+  const size_t size_;
+  std::atomic<size_t> remaining_{0};
+};
+
+template <typename T, typename Pool>
+CrcStream<T, Pool>::CrcStream(const OptionsCrc& options, Pool& pool,
+                              size_t threshold)
+    : pool_(pool),
+      threshold_(std::max(threshold, kMinParallelChunk)),
+      tail_(options),
+      crc_(tail_.crc()) {}
+
+template <typename T, typename Pool>
+template <typename Source>
+CrcTask<T> CrcStream<T, Pool>::Consume(Source& source) {
+  // Initial state shared by the parts of offloaded chunks.
+  const Crc<T> initial = [this] {
+    Crc<T> crc(tail_);
+    crc.reset();
+    return crc;
+  }();
+  for (;;) {
+    const CrcBuffer chunk = co_await source.Next();
+    if (chunk.size == 0) {
+      break;
+    }
+    const auto* data = static_cast<const uint8_t*>(chunk.data);
+    if (chunk.size < threshold_) {
+      tail_.Consume(data, chunk.size);
+      tail_size_ += chunk.size;
+      continue;
+    }
+    Offload offload(initial, pool_, data, chunk.size);
+    const std::vector<T>& parts = co_await offload;
+    for (size_t i = 0; i < parts.size(); ++i) {
+      const size_t offset = i * offload.part_size();
+      Append(parts[i], std::min(offload.part_size(), chunk.size - offset));
+    }
+  }
+  co_return crc();
+}
+
+template <typename T, typename Pool>
+void CrcStream<T, Pool>::Append(T crc, uint64_t size) noexcept {
+  if (tail_size_ > 0) {
+    crc_ = tail_.Combine(crc_, tail_.crc(), tail_size_);
+    tail_.reset();
+    tail_size_ = 0;
+  }
+  crc_ = tail_.Combine(crc_, crc, size);
+}
+
+template <typename T, typename Pool>
+T CrcStream<T, Pool>::crc() const noexcept {
+  return (tail_size_ > 0) ? tail_.Combine(crc_, tail_.crc(), tail_size_)
+                          : crc_;
+}
+
+template <typename T, typename Pool>
+void CrcStream<T, Pool>::reset() noexcept {
+  tail_.reset();
+  tail_size_ = 0;
+  crc_ = tail_.crc();
+}
+
+}  // namespace hash
+
+#endif  // __cpp_impl_coroutine
+
+#endif  // CRC_STREAM_H_
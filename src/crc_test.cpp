@@ -0,0 +1,880 @@
+// Tests of all processing methods and operations against a bitwise reference
+// CRC and the "123456789" check values of the CRC catalogue. Every kernel is
+// run over all sizes up to kSmallSizes and all offsets up to kOffsets, so
+// head, tail and alignment handling is covered for every parameter set.
+// Prints failed checks and exits with status 1 if there were any.
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "checksum_file.h"
+#include "crc.h"
+#include "crc_engine.h"
+#include "crc_stream.h"
+#include "multi_crc.h"
+#include "rolling_crc.h"
+#include "thread_pool.h"
+
+namespace {
+
+int failures = 0;
+
+#define EXPECT(condition)                                               \
+  do {                                                                  \
+    if (!(condition)) {                                                 \
+      ++failures;                                                       \
+      fprintf(stderr, "%s:%d: %s failed\n", __FILE__, __LINE__,         \
+              #condition);                                              \
+    }                                                                   \
+  } while (false)
+
+// Same, with the parameter set and size of the failed check.
+#define EXPECT_CRC(condition, entry, size)                              \
+  do {                                                                  \
+    if (!(condition)) {                                                 \
+      ++failures;                                                       \
+      fprintf(stderr, "%s:%d: %s failed for %s, %zu bytes\n", __FILE__,  \
+              __LINE__, #condition, (entry).name,                       \
+              static_cast<size_t>(size));                               \
+    }                                                                   \
+  } while (false)
+
+constexpr size_t kSmallSizes = 300;
+constexpr size_t kOffsets = 8;
+// Large enough for all streams of SIMD_GATHER.
+constexpr size_t kLargeSize = 16 * hash::kGatherSegment + 77;
+
+constexpr char kCheckData[] = "123456789";
+
+// Parameter set of the catalogue with CRC of kCheckData.
+struct Entry {
+  const char* name;
+  hash::OptionsCrc options;
+  uint64_t check;
+};
+
+using hash::CHUNKS_AUTO;
+using hash::OptionsCrc;
+
+// Widths are explicit, so every entry also runs in all wider registers.
+constexpr Entry kCatalogue[] = {
+    {"CRC-8/SMBUS", OptionsCrc(0x07, 0, 0, false, false, CHUNKS_AUTO, 8), 0xF4},
+    {"CRC-8/MAXIM-DOW", OptionsCrc(0x31, 0, 0, true, true, CHUNKS_AUTO, 8),
+     0xA1},
+    {"CRC-15/CAN", OptionsCrc(0x4599, 0, 0, false, false, CHUNKS_AUTO, 15),
+     0x059E},
+    {"CRC-16/ARC", OptionsCrc(0x8005, 0, 0, true, true, CHUNKS_AUTO, 16),
+     0xBB3D},
+    {"CRC-16/IBM-3740",
+     OptionsCrc(0x1021, 0xFFFF, 0, false, false, CHUNKS_AUTO, 16), 0x29B1},
+    {"CRC-16/XMODEM", OptionsCrc(0x1021, 0, 0, false, false, CHUNKS_AUTO, 16),
+     0x31C3},
+    {"CRC-16/KERMIT", OptionsCrc(0x1021, 0, 0, true, true, CHUNKS_AUTO, 16),
+     0x2189},
+    {"CRC-16/MODBUS",
+     OptionsCrc(0x8005, 0xFFFF, 0, true, true, CHUNKS_AUTO, 16), 0x4B37},
+    {"CRC-16/USB",
+     OptionsCrc(0x8005, 0xFFFF, 0xFFFF, true, true, CHUNKS_AUTO, 16), 0xB4C8},
+    {"CRC-16/DNP", OptionsCrc(0x3D65, 0, 0xFFFF, true, true, CHUNKS_AUTO, 16),
+     0xEA82},
+    {"CRC-24/OPENPGP",
+     OptionsCrc(0x864CFB, 0xB704CE, 0, false, false, CHUNKS_AUTO, 24),
+     0x21CF02},
+    {"CRC-24/BLE",
+     OptionsCrc(0x00065B, 0x555555, 0, true, true, CHUNKS_AUTO, 24), 0xC25A56},
+    {"CRC-32/ISO-HDLC",
+     OptionsCrc(0x04C11DB7, 0xFFFFFFFF, 0xFFFFFFFF, true, true, CHUNKS_AUTO,
+                32),
+     0xCBF43926},
+    {"CRC-32/ISCSI",
+     OptionsCrc(0x1EDC6F41, 0xFFFFFFFF, 0xFFFFFFFF, true, true, CHUNKS_AUTO,
+                32),
+     0xE3069283},
+    {"CRC-32/BZIP2",
+     OptionsCrc(0x04C11DB7, 0xFFFFFFFF, 0xFFFFFFFF, false, false, CHUNKS_AUTO,
+                32),
+     0xFC891918},
+    {"CRC-32/MPEG-2",
+     OptionsCrc(0x04C11DB7, 0xFFFFFFFF, 0, false, false, CHUNKS_AUTO, 32),
+     0x0376E6E7},
+    {"CRC-32/CKSUM",
+     OptionsCrc(0x04C11DB7, 0, 0xFFFFFFFF, false, false, CHUNKS_AUTO, 32),
+     0x765E7680},
+    {"CRC-32/AIXM",
+     OptionsCrc(0x814141AB, 0, 0, false, false, CHUNKS_AUTO, 32), 0x3010BF7F},
+    {"CRC-32/AUTOSAR",
+     OptionsCrc(0xF4ACFB13, 0xFFFFFFFF, 0xFFFFFFFF, true, true, CHUNKS_AUTO,
+                32),
+     0x1697D06A},
+    {"CRC-40/GSM",
+     OptionsCrc(0x0004820009, 0, 0xFFFFFFFFFF, false, false, CHUNKS_AUTO, 40),
+     0xD4164FC646},
+    {"CRC-64/ECMA-182",
+     OptionsCrc(0x42F0E1EBA9EA3693, 0, 0, false, false, CHUNKS_AUTO, 64),
+     0x6C40DF5F0B497347},
+    {"CRC-64/XZ",
+     OptionsCrc(0x42F0E1EBA9EA3693, ~0ull, ~0ull, true, true, CHUNKS_AUTO, 64),
+     0x995DC9BBDF1939FA},
+    {"CRC-64/GO-ISO",
+     OptionsCrc(0x1B, ~0ull, ~0ull, true, true, CHUNKS_AUTO, 64),
+     0xB90956C775A41001},
+    {"CRC-64/WE",
+     OptionsCrc(0x42F0E1EBA9EA3693, ~0ull, ~0ull, false, false, CHUNKS_AUTO,
+                64),
+     0x62EC59E3F1A4F00A}};
+
+// Predefined options of OptionsCrc, in the register of their width.
+template <typename T>
+struct Preset {
+  const char* name;
+  OptionsCrc options;
+  T check;
+};
+
+// Bitwise CRC, independent of the tables and kernels under test.
+uint64_t ReferenceCrc(const OptionsCrc& options, unsigned width,
+                      const uint8_t* data, size_t size) {
+  const auto reflect = [](uint64_t value, unsigned bits) {
+    uint64_t result = 0;
+    for (unsigned i = 0; i < bits; ++i) {
+      result = (result << 1) | (value & 1);
+      value >>= 1;
+    }
+    return result;
+  };
+  const uint64_t mask = ~0ull >> (64 - width);
+  uint64_t crc = options.initial_crc & mask;
+  for (size_t i = 0; i < size; ++i) {
+    const uint64_t byte =
+        (options.reverse_data) ? reflect(data[i], 8) : data[i];
+    for (int bit = 7; bit >= 0; --bit) {
+      const uint64_t top = ((crc >> (width - 1)) ^ (byte >> bit)) & 1;
+      crc = (crc << 1) & mask;
+      if (top) {
+        crc ^= options.polynomial & mask;
+      }
+    }
+  }
+  if (options.reverse_out) {
+    crc = reflect(crc, width);
+  }
+  return (crc ^ options.xor_output) & mask;
+}
+
+template <typename T>
+unsigned Width(const OptionsCrc& options) {
+  return (options.width == 0) ? 8 * sizeof(T) : options.width;
+}
+
+// Same options with another processing method.
+OptionsCrc WithChunks(const OptionsCrc& options, hash::CrcChunks chunks) {
+  return OptionsCrc(options.polynomial, options.initial_crc,
+                    options.xor_output, options.reverse_data,
+                    options.reverse_out, chunks, options.width);
+}
+
+const std::vector<uint8_t>& TestData() {
+  static const std::vector<uint8_t> data = [] {
+    std::vector<uint8_t> result(kLargeSize + kOffsets);
+    std::mt19937 random(7);
+    for (uint8_t& value : result) {
+      value = static_cast<uint8_t>(random());
+    }
+    return result;
+  }();
+  return data;
+}
+
+const uint8_t* CheckBytes() {
+  return reinterpret_cast<const uint8_t*>(kCheckData);
+}
+
+// Long enough to be split into several parts by ConsumeParallel().
+const std::vector<uint8_t>& ParallelData() {
+  static const std::vector<uint8_t> data = [] {
+    std::vector<uint8_t> result(4 * hash::kMinParallelChunk + 4096);
+    for (size_t i = 0; i < result.size(); ++i) {
+      result[i] = TestData()[i % TestData().size()];
+    }
+    return result;
+  }();
+  return data;
+}
+
+// Check value and all sizes and offsets of every processing method.
+template <typename T>
+void TestMethods(const Entry& entry) {
+  const std::vector<uint8_t>& data = TestData();
+  const unsigned width = Width<T>(entry.options);
+  std::vector<uint64_t> expected;
+  for (size_t offset = 0; offset < kOffsets; ++offset) {
+    for (size_t size = 0; size <= kSmallSizes; ++size) {
+      expected.push_back(
+          ReferenceCrc(entry.options, width, data.data() + offset, size));
+    }
+  }
+  const uint64_t large =
+      ReferenceCrc(entry.options, width, data.data() + 1, kLargeSize);
+  for (int method = hash::BYTE_BY_BYTE; method <= hash::CHUNKS_AUTO;
+       ++method) {
+    const auto chunks = static_cast<hash::CrcChunks>(method);
+    hash::Crc<T> crc(WithChunks(entry.options, chunks));
+    crc.Consume(kCheckData, sizeof(kCheckData) - 1);
+    EXPECT_CRC(crc.crc() == entry.check, entry, sizeof(kCheckData) - 1);
+    size_t index = 0;
+    for (size_t offset = 0; offset < kOffsets; ++offset) {
+      for (size_t size = 0; size <= kSmallSizes; ++size) {
+        crc.reset();
+        crc.Consume(data.data() + offset, size);
+        EXPECT_CRC(crc.crc() == expected[index++], entry, size);
+      }
+    }
+    crc.reset();
+    crc.Consume(data.data() + 1, kLargeSize);
+    EXPECT_CRC(crc.crc() == large, entry, kLargeSize);
+    // Pieces of random sizes consumed one after another.
+    std::mt19937 random(method);
+    crc.reset();
+    size_t consumed = 0;
+    while (consumed < 20000) {
+      const size_t size = random() % 700;
+      crc.Consume(data.data() + 1 + consumed, size);
+      consumed += size;
+    }
+    EXPECT_CRC(crc.crc() == ReferenceCrc(entry.options, width,
+                                         data.data() + 1, consumed),
+               entry, consumed);
+  }
+}
+
+template <typename T>
+void TestCombine(const Entry& entry) {
+  const std::vector<uint8_t>& data = TestData();
+  hash::Crc<T> crc(entry.options);
+  std::mt19937 random(3);
+  for (int i = 0; i < 50; ++i) {
+    const size_t size_a = random() % 3000;
+    const size_t size_b = (i == 0) ? 0 : random() % 3000;
+    crc.reset();
+    crc.Consume(data.data(), size_a);
+    const T crc_a = crc.crc();
+    crc.reset();
+    crc.Consume(data.data() + size_a, size_b);
+    const T crc_b = crc.crc();
+    crc.reset();
+    crc.Consume(data.data(), size_a + size_b);
+    EXPECT_CRC(crc.Combine(crc_a, crc_b, size_b) == crc.crc(), entry,
+               size_a + size_b);
+  }
+}
+
+template <typename T>
+void TestUpdate(const Entry& entry) {
+  std::vector<uint8_t> message(TestData().begin(),
+                               TestData().begin() + 70000);
+  hash::Crc<T> crc(entry.options);
+  crc.Consume(message.data(), message.size());
+  T value = crc.crc();
+  std::mt19937 random(5);
+  for (int i = 0; i < 20; ++i) {
+    const size_t offset = random() % message.size();
+    const size_t size = std::min<size_t>(random() % ((i < 10) ? 9 : 2000),
+                                         message.size() - offset);
+    std::vector<uint8_t> changed(size);
+    for (uint8_t& byte : changed) {
+      byte = static_cast<uint8_t>(random());
+    }
+    value = crc.Update(value, offset, message.data() + offset,
+                       changed.data(), size, message.size());
+    std::copy(changed.begin(), changed.end(), message.begin() + offset);
+    hash::Crc<T> full(entry.options);
+    full.Consume(message.data(), message.size());
+    EXPECT_CRC(value == full.crc(), entry, size);
+  }
+}
+
+template <typename T>
+void TestBatch(const Entry& entry) {
+  const std::vector<uint8_t>& data = TestData();
+  const unsigned width = Width<T>(entry.options);
+  std::mt19937 random(11);
+  for (const hash::CrcChunks chunks :
+       {hash::CHUNKS_AUTO, hash::BYTE_BY_BYTE, hash::CHUNKS_8x32b,
+        hash::SIMD_GATHER, hash::HW_CLMUL}) {
+    hash::Crc<T> crc(WithChunks(entry.options, chunks));
+    // Current value does not change the results.
+    crc.Consume(data.data(), 3);
+    for (const size_t count : {0, 1, 3, 4, 5, 17, 100}) {
+      std::vector<hash::CrcBuffer> buffers(count);
+      for (hash::CrcBuffer& buffer : buffers) {
+        buffer.data = data.data() + random() % 1000;
+        buffer.size = (random() % 4 == 0) ? random() % 8 : random() % 700;
+      }
+      std::vector<T> results(count);
+      crc.ChecksumBatch(buffers.data(), count, results.data());
+      for (size_t i = 0; i < count; ++i) {
+        EXPECT_CRC(results[i] == ReferenceCrc(entry.options, width,
+                                              static_cast<const uint8_t*>(
+                                                  buffers[i].data),
+                                              buffers[i].size),
+                   entry, buffers[i].size);
+      }
+    }
+    const std::array<hash::CrcBuffer, 2> pair = {
+        {{kCheckData, sizeof(kCheckData) - 1}, {data.data(), 0}}};
+    const std::array<T, 2> results = crc.ChecksumBatch(pair);
+    EXPECT_CRC(results[0] == entry.check, entry, sizeof(kCheckData) - 1);
+    EXPECT_CRC(results[1] == ReferenceCrc(entry.options, width, data.data(), 0),
+               entry, 0);
+  }
+  // Blocks of VerifyBlocks(), a mismatch in every position of a batch.
+  hash::Crc<T> crc(entry.options);
+  for (const size_t block_size : {1, 37, 512}) {
+    const size_t count = 150;
+    std::vector<T> expected(count);
+    for (size_t i = 0; i < count; ++i) {
+      expected[i] = static_cast<T>(ReferenceCrc(
+          entry.options, width, data.data() + i * block_size, block_size));
+    }
+    EXPECT(crc.VerifyBlocks(data.data(), block_size, expected.data(),
+                            count) == count);
+    EXPECT(crc.VerifyBlocks(data.data(), block_size, expected.data(), 0) ==
+           0);
+    for (const size_t bad : {size_t{0}, size_t{63}, size_t{64}, count - 1}) {
+      std::vector<T> corrupted = expected;
+      corrupted[bad] ^= 1;
+      EXPECT_CRC(crc.VerifyBlocks(data.data(), block_size, corrupted.data(),
+                                  count) == bad,
+                 entry, block_size);
+    }
+  }
+}
+
+template <typename T>
+void TestChain(const Entry& entry) {
+  const std::vector<uint8_t>& data = TestData();
+  std::mt19937 random(13);
+  for (int i = 0; i < 20; ++i) {
+    std::vector<hash::CrcBuffer> segments;
+    size_t total = 0;
+    while (total < 5000) {
+      // Mostly short segments, some empty and some long.
+      const size_t size = (random() % 8 == 0) ? random() % 2000
+                                              : random() % 24;
+      segments.push_back({data.data() + total, size});
+      total += size;
+    }
+    hash::Crc<T> crc(entry.options);
+    crc.Consume(data.data(), 0);
+    crc.Consume(segments.data(), segments.size());
+    hash::Crc<T> contiguous(entry.options);
+    contiguous.Consume(data.data(), total);
+    EXPECT_CRC(crc.crc() == contiguous.crc(), entry, total);
+#if defined(HASHLIB_POSIX_IOVEC)
+    std::vector<iovec> vectors;
+    for (const hash::CrcBuffer& segment : segments) {
+      vectors.push_back({const_cast<void*>(segment.data), segment.size});
+    }
+    crc.reset();
+    crc.Consume(vectors.data(), vectors.size());
+    EXPECT_CRC(crc.crc() == contiguous.crc(), entry, total);
+#endif
+  }
+}
+
+template <typename T>
+void TestCopy(const Entry& entry) {
+  const std::vector<uint8_t>& data = TestData();
+  // Last size takes the non-temporal store path.
+  for (const size_t size : {size_t{0}, size_t{1}, size_t{100},
+                            size_t{70001}, kLargeSize}) {
+    std::vector<uint8_t> copy(size + 1, 0);
+    hash::Crc<T> crc(entry.options);
+    crc.CopyAndConsume(copy.data() + 1, data.data() + 3, size);
+    EXPECT_CRC(std::equal(copy.begin() + 1, copy.end(), data.begin() + 3),
+               entry, size);
+    hash::Crc<T> consumed(entry.options);
+    consumed.Consume(data.data() + 3, size);
+    EXPECT_CRC(crc.crc() == consumed.crc(), entry, size);
+  }
+}
+
+template <typename T>
+void TestRolling(const Entry& entry) {
+  const std::vector<uint8_t>& data = TestData();
+  for (const size_t window : {1, 4, 16, 48, 64}) {
+    hash::RollingCrc<T> rolling(window, entry.options);
+    for (size_t i = 0; i < window; ++i) {
+      rolling.Push(data[i]);
+    }
+    for (size_t i = window; i < window + 200; ++i) {
+      hash::Crc<T> crc(entry.options);
+      crc.Consume(data.data() + i - window, window);
+      EXPECT_CRC(rolling.crc() == crc.crc(), entry, window);
+      rolling.Roll(data[i - window], data[i]);
+    }
+    // Boundary at the earliest window with the value of the one at 100.
+    const T mask = 0xFF;
+    hash::Crc<T> crc(entry.options);
+    crc.Consume(data.data() + 100, window);
+    const T value = crc.crc() & mask;
+    const size_t boundary = rolling.FindBoundary(data.data(), 5000, mask,
+                                                 value);
+    EXPECT_CRC(boundary >= window && boundary <= 100 + window, entry, window);
+    for (size_t end = window; end <= boundary; ++end) {
+      crc.reset();
+      crc.Consume(data.data() + end - window, window);
+      EXPECT_CRC(((crc.crc() & mask) == value) == (end == boundary), entry,
+                 end);
+    }
+  }
+}
+
+template <typename T, typename Pool>
+void TestParallel(const Entry& entry, Pool& pool) {
+  const std::vector<uint8_t>& data = ParallelData();
+  hash::Crc<T> consumed(entry.options);
+  for (const size_t size :
+       {size_t{1000}, size_t{70001}, 2 * hash::kMinParallelChunk + 3,
+        4 * hash::kMinParallelChunk + 77}) {
+    hash::Crc<T> crc(entry.options);
+    crc.Consume(data.data(), 5);
+    crc.ConsumeParallel(data.data() + 5, size, pool, 0);
+    consumed.reset();
+    consumed.Consume(data.data(), size + 5);
+    EXPECT_CRC(crc.crc() == consumed.crc(), entry, size);
+  }
+}
+
+template <typename T>
+void TestEngine(const Entry& entry) {
+  const std::vector<uint8_t>& data = TestData();
+  for (const hash::CrcTablePlacement placement :
+       {hash::TABLE_SHARED, hash::TABLE_NODE_LOCAL,
+        hash::TABLE_NODE_LOCAL_HUGE_PAGES}) {
+    const hash::CrcEngine<T> engine(entry.options, placement);
+    // Streams consumed concurrently through the shared engine.
+    std::vector<T> results(4);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < results.size(); ++i) {
+      threads.emplace_back([&, i] {
+        hash::CrcState<T> state = engine.NewState();
+        for (size_t offset = 0; offset < 9000; offset += 900) {
+          engine.Consume(state, data.data() + i + offset, 900);
+        }
+        results[i] = engine.crc(state);
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    for (size_t i = 0; i < results.size(); ++i) {
+      hash::Crc<T> crc(entry.options);
+      crc.Consume(data.data() + i, 9000);
+      EXPECT_CRC(results[i] == crc.crc(), entry, 9000);
+    }
+    hash::CrcState<T> state = engine.NewState();
+    engine.Consume(state, kCheckData, sizeof(kCheckData) - 1);
+    EXPECT_CRC(engine.crc(state) == entry.check, entry,
+               sizeof(kCheckData) - 1);
+    engine.reset(state);
+    EXPECT_CRC(engine.crc(state) == engine.crc(engine.NewState()), entry, 0);
+  }
+}
+
+template <typename T>
+void TestEntry(const Entry& entry) {
+  if (Width<T>(entry.options) > 8 * sizeof(T)) {
+    return;
+  }
+  TestMethods<T>(entry);
+  TestCombine<T>(entry);
+  TestUpdate<T>(entry);
+  TestBatch<T>(entry);
+  TestChain<T>(entry);
+  TestCopy<T>(entry);
+  TestRolling<T>(entry);
+  TestEngine<T>(entry);
+}
+
+void TestCatalogue() {
+  hash::ThreadPool pool(3);
+  hash::WorkStealingPool stealing_pool(3);
+  for (const Entry& entry : kCatalogue) {
+    TestEntry<uint8_t>(entry);
+    TestEntry<uint16_t>(entry);
+    TestEntry<uint32_t>(entry);
+    TestEntry<uint64_t>(entry);
+    if (entry.options.width <= 32) {
+      TestParallel<uint32_t>(entry, pool);
+    }
+    TestParallel<uint64_t>(entry, stealing_pool);
+  }
+}
+
+// Pool failing to schedule its second task, e.g. when out of memory.
+struct FailingPool {
+  hash::ThreadPool& pool;
+  size_t submitted = 0;
+
+  size_t size() const noexcept { return pool.size(); }
+  template <typename F>
+  auto Submit(F&& task) {
+    if (++submitted == 2) {
+      throw std::runtime_error("Submit failed");
+    }
+    return pool.Submit(std::forward<F>(task));
+  }
+};
+
+// Exception of the pool is passed on once the submitted parts are done.
+void TestParallelFailure() {
+  hash::ThreadPool pool(3);
+  FailingPool failing = {pool};
+  hash::Crc<uint32_t> crc = hash::NewCrc32();
+  bool thrown = false;
+  try {
+    crc.ConsumeParallel(ParallelData().data(), ParallelData().size(), failing,
+                        0);
+  } catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  EXPECT(thrown);
+  EXPECT(failing.submitted == 2);
+}
+
+// Tables of other polynomials are generated once per process, also for
+// instances constructed concurrently. Runs first, before the tables exist.
+void TestSharedTables() {
+  const auto is_32 = [](const Entry& entry) {
+    return entry.options.width == 32;
+  };
+  const auto expected = std::count_if(std::begin(kCatalogue),
+                                      std::end(kCatalogue), is_32);
+  std::vector<long> matches(4, 0);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < matches.size(); ++i) {
+    threads.emplace_back([&, i] {
+      for (const Entry& entry : kCatalogue) {
+        if (is_32(entry)) {
+          hash::Crc<uint32_t> crc(entry.options);
+          crc.Consume(kCheckData, sizeof(kCheckData) - 1);
+          matches[i] += (crc.crc() == entry.check);
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (const long count : matches) {
+    EXPECT(count == expected);
+  }
+}
+
+void TestMultiCrc() {
+  const std::vector<uint8_t>& data = TestData();
+  hash::MultiCrc crcs(hash::NewCrc16(), hash::NewCrc32(),
+                      hash::Crc<uint32_t>(OptionsCrc::Crc32C()),
+                      hash::NewCrc64());
+  crcs.Consume(data.data(), kLargeSize);
+  hash::Crc<uint32_t> crc32c(OptionsCrc::Crc32C());
+  crc32c.Consume(data.data(), kLargeSize);
+  EXPECT(crcs.crc<2>() == crc32c.crc());
+  hash::Crc<uint64_t> crc64 = hash::NewCrc64();
+  crc64.Consume(data.data(), kLargeSize);
+  EXPECT(std::get<3>(crcs.crc()) == crc64.crc());
+  crcs.reset();
+  crcs.Consume(kCheckData, sizeof(kCheckData) - 1);
+  EXPECT(crcs.crc() == std::make_tuple(uint16_t{0xBB3D}, 0xCBF43926u,
+                                       0xE3069283u, 0x995DC9BBDF1939FAull));
+}
+
+void TestChecksumFile() {
+  const std::string path =
+      (std::filesystem::temp_directory_path() / "hashlib_crc_test.bin")
+          .string();
+  for (const size_t size : {size_t{0}, sizeof(kCheckData) - 1, kLargeSize}) {
+    {
+      std::ofstream file(path, std::ios_base::binary | std::ios_base::trunc);
+      file.write((size == sizeof(kCheckData) - 1)
+                     ? kCheckData
+                     : reinterpret_cast<const char*>(TestData().data()),
+                 static_cast<std::streamsize>(size));
+    }
+    hash::Crc<uint32_t> crc = hash::NewCrc32();
+    crc.Consume((size == sizeof(kCheckData) - 1) ? CheckBytes()
+                                                 : TestData().data(),
+                size);
+    EXPECT(hash::ChecksumFile<uint32_t>(path) == crc.crc());
+    hash::MultiCrc crcs(hash::NewCrc32(), hash::NewCrc64());
+    EXPECT(hash::ConsumeFile(path, crcs));
+    EXPECT(crcs.crc<0>() == crc.crc());
+  }
+  std::filesystem::remove(path);
+  EXPECT(!hash::ChecksumFile<uint32_t>(path));
+  // Files of /proc report size 0, but have content.
+  const char* proc_path = "/proc/self/cmdline";
+  std::ifstream proc(proc_path, std::ios_base::binary);
+  if (proc) {
+    const std::string content((std::istreambuf_iterator<char>(proc)),
+                              std::istreambuf_iterator<char>());
+    hash::Crc<uint32_t> crc = hash::NewCrc32();
+    crc.Consume(content.data(), content.size());
+    EXPECT(!content.empty());
+    EXPECT(hash::ChecksumFile<uint32_t>(proc_path) == crc.crc());
+  }
+}
+
+// Tables hold only the slices of the selected method and grow for wider ones.
+void TestTableSlices() {
+  // CRC-32/XFER is not used by other tests, so its table is generated here.
+  const OptionsCrc options(0x000000AF, 0, 0, false, false, hash::BYTE_BY_BYTE);
+  hash::Crc<uint32_t> crc(options);
+  EXPECT(crc.table_footprint() ==
+         hash::TableFootprint<uint32_t>(hash::BYTE_BY_BYTE));
+  crc.Consume(kCheckData, sizeof(kCheckData) - 1, hash::CHUNKS_8x32b);
+  EXPECT(crc.table_footprint() ==
+         hash::TableFootprint<uint32_t>(hash::CHUNKS_8x32b));
+  EXPECT(crc.crc() == 0xBD0BE338);
+}
+
+template <typename T>
+void TestPresets(const std::vector<Preset<T>>& presets) {
+  for (const Preset<T>& preset : presets) {
+    hash::Crc<T> crc(preset.options);
+    crc.Consume(kCheckData, sizeof(kCheckData) - 1);
+    const Entry entry = {preset.name, preset.options, preset.check};
+    EXPECT_CRC(crc.crc() == preset.check, entry, sizeof(kCheckData) - 1);
+  }
+}
+
+static_assert(hash::SizeClass(0) == 0 && hash::SizeClass(64) == 0 &&
+                  hash::SizeClass(65) == 1 &&
+                  hash::SizeClass(~size_t{0}) == hash::kSizeClasses - 1,
+              "Size classes include their upper bound");
+
+// Default consumption never allocates, so it can not throw.
+static_assert(noexcept(std::declval<hash::Crc<uint64_t>&>().Consume(
+                  std::declval<const uint8_t*>(), size_t{0})),
+              "Crc::Consume is noexcept");
+static_assert(noexcept(std::declval<hash::Crc32Static&>().Consume(
+                  std::declval<const uint8_t*>(), size_t{0})),
+              "StaticCrc::Consume is noexcept");
+
+// Compile time and Static CRCs of the predefined options.
+static_assert(hash::Crc16Of(kCheckData) == 0xBB3D, "CRC16 check value");
+static_assert(hash::Crc32Of(kCheckData) == 0xCBF43926, "CRC32 check value");
+static_assert(hash::Crc32COf(kCheckData) == 0xE3069283, "CRC32C check value");
+static_assert(hash::Crc64Of(kCheckData) == 0x995DC9BBDF1939FA,
+              "CRC64 check value");
+static_assert(hash::Crc32Static::Combine(hash::Crc32Of("1234"),
+                                         hash::Crc32Of("56789"),
+                                         5) == 0xCBF43926,
+              "Combine at compile time");
+static_assert(hash::Crc32Of("a\0b") ==
+                  hash::Crc32Of(std::string_view("a\0b", 3)),
+              "Literals are hashed up to their end");
+
+template <typename S>
+void TestStatic(const OptionsCrc& options) {
+  const std::vector<uint8_t>& data = TestData();
+  const unsigned width = sizeof(decltype(S().crc())) * 8;
+  for (int method = hash::BYTE_BY_BYTE; method <= hash::CHUNKS_AUTO;
+       ++method) {
+    for (const size_t size : {0, 1, 15, 100, 4999}) {
+      S crc(static_cast<hash::CrcChunks>(method));
+      crc.Consume(data.data() + 1, size);
+      EXPECT(crc.crc() ==
+             ReferenceCrc(options, width, data.data() + 1, size));
+    }
+  }
+}
+
+void TestStaticCrcs() {
+  TestStatic<hash::Crc16Static>(OptionsCrc::Crc16());
+  TestStatic<hash::Crc16_CCITTStatic>(OptionsCrc::Crc16_CCITT());
+  TestStatic<hash::Crc32Static>(OptionsCrc::Crc32());
+  TestStatic<hash::Crc32CStatic>(OptionsCrc::Crc32C());
+  TestStatic<hash::Crc64Static>(OptionsCrc::Crc64());
+  TestStatic<hash::Crc64_ISOStatic>(OptionsCrc::Crc64_ISO());
+}
+
+// Calibration selects a method once per process, later calls keep it.
+void TestDispatcher() {
+  hash::Crc<uint32_t> crc = hash::NewCrc32();
+  crc.Optimize(1024, 4);
+  const hash::CrcChunks selected = hash::CrcDispatcher<uint32_t>::Get(true);
+  EXPECT(selected != hash::CHUNKS_AUTO);
+  hash::Crc<uint32_t>(OptionsCrc::Crc32C()).Optimize(1024, 4);
+  EXPECT(hash::CrcDispatcher<uint32_t>::Get(true) == selected);
+  // Every size class has a method of its own, tables fit all of them.
+  for (const size_t size : {size_t{0}, size_t{64}, size_t{65}, size_t{4096},
+                            size_t{1} << 20}) {
+    const hash::CrcChunks chunks =
+        hash::CrcDispatcher<uint32_t>::Get(true, size);
+    EXPECT(chunks != hash::CHUNKS_AUTO);
+    EXPECT(hash::TableSlices(chunks) <=
+           hash::CrcDispatcher<uint32_t>::Slices(true));
+  }
+  EXPECT(hash::CrcDispatcher<uint32_t>::Get(true, size_t{1} << 20) ==
+         selected);
+  crc.Consume(kCheckData, sizeof(kCheckData) - 1);
+  EXPECT(crc.crc() == 0xCBF43926);
+}
+
+// Counters are plain values, usable without HASHLIB_CRC_STATS.
+void TestStats() {
+  hash::CrcStats stats;
+  stats.Record(hash::CHUNKS_8x32b, 0, 1);
+  stats.Record(hash::CHUNKS_8x32b, 64, 2);
+  stats.Record(hash::CHUNKS_AUTO, ~size_t{0}, 3);
+  hash::CrcStats total = stats;
+  total += stats;
+  EXPECT(total.bytes[hash::CHUNKS_8x32b] == 128);
+  EXPECT(total.calls[hash::CHUNKS_8x32b] == 4);
+  EXPECT(total.size_histogram[0] == 2 && total.size_histogram[7] == 2);
+  EXPECT(total.size_histogram[hash::CrcStats::kSizeBuckets - 1] == 2);
+  EXPECT(total.cycles == 12);
+  hash::Crc<uint32_t> crc = hash::NewCrc32();
+  crc.Consume(kCheckData, sizeof(kCheckData) - 1);
+  crc.reset_stats();
+  EXPECT(crc.stats().calls[hash::BYTE_BY_BYTE] == 0);
+}
+
+#if defined(HASHLIB_COROUTINES)
+
+// Chunks of 'data' of given sizes, consumed one after another.
+struct Source {
+  struct Awaiter {
+    Source* source;
+    bool await_ready() const noexcept { return true; }
+    void await_suspend(std::coroutine_handle<>) const noexcept {}
+    hash::CrcBuffer await_resume() const noexcept {
+      if (source->next == source->sizes.size()) {
+        return {nullptr, 0};
+      }
+      const hash::CrcBuffer chunk = {source->data.data() + source->consumed,
+                                     source->sizes[source->next++]};
+      source->consumed += chunk.size;
+      return chunk;
+    }
+  };
+  Awaiter Next() { return {this}; }
+
+  std::vector<uint8_t> data;
+  std::vector<size_t> sizes;
+  size_t next = 0;
+  size_t consumed = 0;
+};
+
+// Eagerly started coroutine storing the result of the stream.
+struct Driver {
+  struct promise_type {
+    Driver get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() const noexcept { return {}; }
+    std::suspend_never final_suspend() const noexcept { return {}; }
+    void return_void() const noexcept {}
+    void unhandled_exception() const noexcept { std::terminate(); }
+  };
+};
+
+template <typename Stream>
+Driver Drive(Stream& stream, Source& source, std::promise<uint32_t>& result) {
+  result.set_value(co_await stream.Consume(source));
+}
+
+template <typename Pool>
+void TestStream(Pool& pool) {
+  // Long chunks are offloaded to the pool, short ones consumed inline.
+  Source source;
+  source.sizes = {100, hash::kMinParallelChunk * 3 + 5, 7,
+                  hash::kMinParallelChunk, 1000};
+  size_t total = 0;
+  for (const size_t size : source.sizes) {
+    total += size;
+  }
+  source.data.assign(ParallelData().begin(), ParallelData().begin() + total);
+  hash::CrcStream<uint32_t, Pool> stream(OptionsCrc::Crc32C(), pool, 0);
+  std::promise<uint32_t> result;
+  std::future<uint32_t> value = result.get_future();
+  Drive(stream, source, result);
+  hash::Crc<uint32_t> crc(OptionsCrc::Crc32C());
+  crc.Consume(source.data.data(), total);
+  EXPECT(value.get() == crc.crc());
+  EXPECT(source.consumed == total);
+}
+
+void TestStreams() {
+  hash::ThreadPool pool(3);
+  hash::WorkStealingPool stealing_pool(3);
+  TestStream(pool);
+  TestStream(stealing_pool);
+}
+
+#endif  // HASHLIB_COROUTINES
+
+void TestProfile() {
+  hash::Crc<uint32_t> crc = hash::NewCrc32();
+  crc.Optimize(1024, 4);
+  const std::string profile = hash::SaveCrcProfile();
+  EXPECT(profile.find("crc32 reflected") != std::string::npos);
+  EXPECT(hash::LoadCrcProfile(profile));
+  EXPECT(!hash::LoadCrcProfile("crc32 reflected NOT_A_METHOD\n"));
+  EXPECT(hash::SaveCrcProfile() == profile);
+  crc.Consume(kCheckData, sizeof(kCheckData) - 1);
+  EXPECT(crc.crc() == 0xCBF43926);
+}
+
+}  // namespace
+
+int main() {
+  TestSharedTables();
+  TestCatalogue();
+  TestParallelFailure();
+  TestStats();
+  TestPresets<uint8_t>({{"Crc8", OptionsCrc::Crc8(), 0xF4},
+                        {"Crc8_MAXIM", OptionsCrc::Crc8_MAXIM(), 0xA1}});
+  TestPresets<uint16_t>({{"Crc15_CAN", OptionsCrc::Crc15_CAN(), 0x059E},
+                         {"Crc16", OptionsCrc::Crc16(), 0xBB3D},
+                         {"Crc16_CCITT", OptionsCrc::Crc16_CCITT(), 0x29B1}});
+  TestPresets<uint32_t>(
+      {{"Crc24_OPENPGP", OptionsCrc::Crc24_OPENPGP(), 0x21CF02},
+       {"Crc24_BLE", OptionsCrc::Crc24_BLE(), 0xC25A56},
+       {"Crc32", OptionsCrc::Crc32(), 0xCBF43926},
+       {"Crc32C", OptionsCrc::Crc32C(), 0xE3069283}});
+  // CRC-64/ISO without initial value and output xor is not in the
+  // catalogue, its check value is the one of the bitwise reference.
+  TestPresets<uint64_t>(
+      {{"Crc40_GSM", OptionsCrc::Crc40_GSM(), 0xD4164FC646},
+       {"Crc64", OptionsCrc::Crc64(), 0x995DC9BBDF1939FA},
+       {"Crc64_ISO", OptionsCrc::Crc64_ISO(), 0x46A5A9388A5BEFFE}});
+  TestTableSlices();
+  TestStaticCrcs();
+  TestMultiCrc();
+  TestChecksumFile();
+#if defined(HASHLIB_COROUTINES)
+  TestStreams();
+#endif
+  TestDispatcher();
+  // Pins the dispatchers, so it runs last.
+  TestProfile();
+  if (failures > 0) {
+    fprintf(stderr, "%d checks failed\n", failures);
+    return 1;
+  }
+  printf("All checks passed\n");
+  return 0;
+}
@@ -0,0 +1,478 @@
+// hashlib-sum: print or check CRC checksums of files in the format of
+// sha256sum ("<hex>  <path>" lines).
+//
+// Usage: hashlib-sum [-a ALGORITHM] [-j THREADS] [PATH]...
+//        hashlib-sum [-a ALGORITHM] [-j THREADS] -c [LIST]...
+// With no PATH or LIST, or when it is "-", standard input is read, later "-"
+// are empty as in sha256sum. Directories are walked recursively, files of
+// every directory are sorted by path. Files are hashed by a work stealing
+// pool: small files in batches computed by Crc::ChecksumBatch(), large files
+// split into parts whose CRC values are merged with Crc::Combine(). Files are
+// read until the end, whatever size they report. Results are printed in order.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "crc.h"
+#include "thread_pool.h"
+
+namespace {
+
+namespace fs = std::filesystem;
+
+struct Algorithm {
+  const char* name;
+  hash::OptionsCrc options;
+  size_t bits;
+};
+
+constexpr Algorithm kAlgorithms[] = {
+    {"crc16", hash::OptionsCrc::Crc16(), 16},
+    {"crc16-ccitt", hash::OptionsCrc::Crc16_CCITT(), 16},
+    {"crc32", hash::OptionsCrc::Crc32(), 32},
+    {"crc32c", hash::OptionsCrc::Crc32C(), 32},
+    {"crc64", hash::OptionsCrc::Crc64(), 64},
+    {"crc64-iso", hash::OptionsCrc::Crc64_ISO(), 64}};
+
+// Files up to this size are read whole and hashed in batches.
+constexpr uint64_t kBatchFileSize = 64 * 1024;
+constexpr size_t kBatchFiles = 64;
+constexpr uint64_t kBatchBytes = 1024 * 1024;
+// Larger files are split into parts of this size, hashed concurrently.
+constexpr uint64_t kPartSize = 16 * 1024 * 1024;
+constexpr size_t kReadBlock = 1024 * 1024;
+// Jobs scheduled ahead of the printed results, per worker thread.
+constexpr size_t kJobsPerThread = 16;
+// Size of files which are not regular (pipes, devices), read until the end.
+constexpr uint64_t kUnknownSize = ~static_cast<uint64_t>(0);
+// Path of the standard input.
+constexpr char kStdin[] = "-";
+
+struct File {
+  std::string path;
+  uint64_t size = 0;
+  // Standard input is read by its first occurrence, later ones are empty.
+  bool empty = false;
+};
+
+// Add the standard input to 'files'.
+void AddStdin(std::vector<File>* files) {
+  const bool read =
+      std::any_of(files->begin(), files->end(),
+                  [](const File& file) { return file.path == kStdin; });
+  files->push_back({kStdin, (read) ? 0 : kUnknownSize, read});
+}
+
+// Stream of 'path' opened into 'file', or the standard input.
+std::istream& Open(const std::string& path, std::ifstream& file) {
+  if (path == kStdin) {
+    return std::cin;
+  }
+  file.open(path, std::ios_base::binary);
+  return file;
+}
+
+// Read 'input' until the end into 'content', 'size' bytes are expected.
+// Returns false on read error.
+bool ReadAll(std::istream& input, uint64_t size,
+             std::vector<uint8_t>* content) {
+  content->resize(static_cast<size_t>(size));
+  size_t total = 0;
+  while (input) {
+    if (total == content->size()) {
+      content->resize(std::max<size_t>(2 * total, kReadBlock));
+    }
+    input.read(reinterpret_cast<char*>(content->data() + total),
+               static_cast<std::streamsize>(content->size() - total));
+    total += static_cast<size_t>(input.gcount());
+  }
+  content->resize(total);
+  return input.eof() && !input.bad();
+}
+
+// Add 'path' or all regular files under it to 'files'. Returns false if the
+// path does not exist or the directory can not be walked.
+bool Collect(const std::string& path, std::vector<File>* files) {
+  if (path == kStdin) {
+    AddStdin(files);
+    return true;
+  }
+  std::error_code error;
+  const fs::file_status status = fs::status(path, error);
+  if (error) {
+    fprintf(stderr, "hashlib-sum: %s: %s\n", path.c_str(),
+            error.message().c_str());
+    return false;
+  }
+  if (fs::is_regular_file(status)) {
+    files->push_back({path, fs::file_size(path, error)});
+    return !error;
+  }
+  if (!fs::is_directory(status)) {
+    files->push_back({path, kUnknownSize});
+    return true;
+  }
+  std::vector<File> found;
+  for (fs::recursive_directory_iterator
+           it(path, fs::directory_options::skip_permission_denied, error),
+       end;
+       !error && it != end; it.increment(error)) {
+    if (it->is_regular_file(error)) {
+      found.push_back({it->path().string(), it->file_size(error)});
+    }
+  }
+  if (error) {
+    fprintf(stderr, "hashlib-sum: %s: %s\n", path.c_str(),
+            error.message().c_str());
+    return false;
+  }
+  std::sort(found.begin(), found.end(),
+            [](const File& a, const File& b) { return a.path < b.path; });
+  files->insert(files->end(), found.begin(), found.end());
+  return true;
+}
+
+template <typename T>
+class Hasher {
+ public:
+  Hasher(const hash::OptionsCrc& options, size_t threads)
+      : crc_(options), pool_(threads) {}
+
+  // Hash all files, calling report(file, crc) in the order of 'files'. CRC
+  // is std::nullopt if the file could not be read.
+  template <typename Report>
+  void Hash(const std::vector<File>& files, Report report);
+
+ private:
+  // CRC of a part of a file and its size.
+  struct Part {
+    T crc;
+    uint64_t size;
+  };
+
+  // Scheduled batch of small files or parts of a single file.
+  struct Job {
+    size_t first = 0;
+    size_t count = 0;
+    std::future<std::vector<std::optional<T>>> batch;
+    std::vector<std::future<std::optional<Part>>> parts;
+  };
+
+  Job Schedule(const std::vector<File>& files, size_t first);
+  std::vector<std::optional<T>> HashBatch(const File* files,
+                                          size_t count) const;
+  // Hash 'size' bytes from 'offset', or until the end of file for
+  // kUnknownSize.
+  std::optional<Part> HashPart(const std::string& path, uint64_t offset,
+                               uint64_t size) const;
+
+  // Reset instance copied by every task, copies share the table.
+  const hash::Crc<T> crc_;
+  hash::WorkStealingPool pool_;
+};
+
+template <typename T>
+template <typename Report>
+void Hasher<T>::Hash(const std::vector<File>& files, Report report) {
+  const size_t window = kJobsPerThread * pool_.size();
+  std::deque<Job> jobs;
+  size_t next = 0;
+  while (next < files.size() || !jobs.empty()) {
+    while (next < files.size() && jobs.size() < window) {
+      jobs.push_back(Schedule(files, next));
+      next += jobs.back().count;
+    }
+    Job& job = jobs.front();
+    if (job.batch.valid()) {
+      const std::vector<std::optional<T>> results = job.batch.get();
+      for (size_t i = 0; i < job.count; ++i) {
+        report(files[job.first + i], results[i]);
+      }
+    } else {
+      const std::optional<Part> first = job.parts[0].get();
+      std::optional<T> result;
+      if (first) {
+        result = first->crc;
+      }
+      for (size_t i = 1; i < job.parts.size(); ++i) {
+        const std::optional<Part> part = job.parts[i].get();
+        result = (result && part) ? std::optional<T>(crc_.Combine(
+                                        *result, part->crc, part->size))
+                                  : std::nullopt;
+      }
+      report(files[job.first], result);
+    }
+    jobs.pop_front();
+  }
+}
+
+template <typename T>
+typename Hasher<T>::Job Hasher<T>::Schedule(const std::vector<File>& files,
+                                            size_t first) {
+  Job job;
+  job.first = first;
+  const File& file = files[first];
+  if (file.size != kUnknownSize && file.size <= kBatchFileSize) {
+    uint64_t bytes = 0;
+    while (first + job.count < files.size() && job.count < kBatchFiles &&
+           bytes < kBatchBytes) {
+      const File& small = files[first + job.count];
+      if (small.size == kUnknownSize || small.size > kBatchFileSize) {
+        break;
+      }
+      bytes += small.size;
+      ++job.count;
+    }
+    const File* batch = &files[first];
+    const size_t count = job.count;
+    job.batch = pool_.Submit([=] { return HashBatch(batch, count); });
+    return job;
+  }
+  job.count = 1;
+  if (file.size == kUnknownSize) {
+    const std::string path = file.path;
+    job.parts.push_back(
+        pool_.Submit([=] { return HashPart(path, 0, kUnknownSize); }));
+    return job;
+  }
+  for (uint64_t offset = 0; offset < file.size; offset += kPartSize) {
+    const std::string path = file.path;
+    // The last part is read until the end, in case the file has grown.
+    const uint64_t size =
+        (file.size - offset > kPartSize) ? kPartSize : kUnknownSize;
+    job.parts.push_back(
+        pool_.Submit([=] { return HashPart(path, offset, size); }));
+  }
+  return job;
+}
+
+template <typename T>
+std::vector<std::optional<T>> Hasher<T>::HashBatch(const File* files,
+                                                   size_t count) const {
+  std::vector<std::vector<uint8_t>> contents(count);
+  std::vector<hash::CrcBuffer> buffers;
+  std::vector<size_t> indexes;
+  std::vector<std::optional<T>> results(count);
+  for (size_t i = 0; i < count; ++i) {
+    // Size is a hint only, e.g. files of /proc report size 0.
+    if (!files[i].empty) {
+      std::ifstream file;
+      std::istream& input = Open(files[i].path, file);
+      if (!input || !ReadAll(input, files[i].size, &contents[i])) {
+        continue;
+      }
+    }
+    buffers.push_back({contents[i].data(), contents[i].size()});
+    indexes.push_back(i);
+  }
+  std::vector<T> crcs(buffers.size());
+  crc_.ChecksumBatch(buffers.data(), buffers.size(), crcs.data());
+  for (size_t i = 0; i < indexes.size(); ++i) {
+    results[indexes[i]] = crcs[i];
+  }
+  return results;
+}
+
+template <typename T>
+std::optional<typename Hasher<T>::Part> Hasher<T>::HashPart(
+    const std::string& path, uint64_t offset, uint64_t size) const {
+  thread_local std::vector<char> buffer(kReadBlock);
+  std::ifstream file;
+  std::istream& input = Open(path, file);
+  // Pipes can not seek, but are read from the start only.
+  if (!input ||
+      (offset > 0 && !input.seekg(static_cast<std::streamoff>(offset)))) {
+    return std::nullopt;
+  }
+  hash::Crc<T> crc(crc_);
+  // Unknown size is read until the end of the file.
+  const bool until_end = (size == kUnknownSize);
+  uint64_t total = 0;
+  while (total < size) {
+    const auto block =
+        static_cast<size_t>(std::min<uint64_t>(size - total, kReadBlock));
+    input.read(buffer.data(), static_cast<std::streamsize>(block));
+    const auto count = static_cast<size_t>(input.gcount());
+    crc.Consume(buffer.data(), count);
+    total += count;
+    if (count < block) {
+      if (until_end && input.eof() && !input.bad()) {
+        break;
+      }
+      return std::nullopt;
+    }
+  }
+  return Part{crc.crc(), total};
+}
+
+// Parse "<hex>  <path>" or "<hex> *<path>" line of the checksum list.
+bool ParseLine(const std::string& line, size_t digits, uint64_t* value,
+               std::string* path) {
+  if (line.size() < digits + 3 || line[digits] != ' ' ||
+      (line[digits + 1] != ' ' && line[digits + 1] != '*')) {
+    return false;
+  }
+  const std::string hex = line.substr(0, digits);
+  char* end = nullptr;
+  *value = std::strtoull(hex.c_str(), &end, 16);
+  if (end != hex.c_str() + digits) {
+    return false;
+  }
+  *path = line.substr(digits + 2);
+  return true;
+}
+
+template <typename T>
+int Print(const Algorithm& algorithm, size_t threads,
+          const std::vector<std::string>& paths) {
+  int status = 0;
+  std::vector<File> files;
+  for (const std::string& path : paths) {
+    if (!Collect(path, &files)) {
+      status = 1;
+    }
+  }
+  const int digits = static_cast<int>(algorithm.bits / 4);
+  Hasher<T> hasher(algorithm.options, threads);
+  hasher.Hash(files, [&](const File& file, const std::optional<T>& crc) {
+    if (!crc) {
+      fprintf(stderr, "hashlib-sum: %s: read error\n", file.path.c_str());
+      status = 1;
+      return;
+    }
+    printf("%0*llx  %s\n", digits, static_cast<unsigned long long>(*crc),
+           file.path.c_str());
+  });
+  return status;
+}
+
+template <typename T>
+int Check(const Algorithm& algorithm, size_t threads,
+          const std::vector<std::string>& lists) {
+  int status = 0;
+  std::vector<File> files;
+  std::vector<uint64_t> expected;
+  for (const std::string& list : lists) {
+    std::ifstream file;
+    std::istream& input = Open(list, file);
+    if (!input) {
+      fprintf(stderr, "hashlib-sum: %s: can not open\n", list.c_str());
+      status = 1;
+      continue;
+    }
+    std::string line;
+    while (std::getline(input, line)) {
+      uint64_t value = 0;
+      std::string path;
+      if (!ParseLine(line, algorithm.bits / 4, &value, &path)) {
+        fprintf(stderr, "hashlib-sum: %s: improperly formatted line\n",
+                list.c_str());
+        status = 1;
+        continue;
+      }
+      if (path == kStdin) {
+        AddStdin(&files);
+      } else {
+        std::error_code error;
+        const uint64_t size = fs::file_size(path, error);
+        files.push_back({path, (error) ? kUnknownSize : size});
+      }
+      expected.push_back(value);
+    }
+  }
+  size_t index = 0;
+  size_t failed = 0;
+  Hasher<T> hasher(algorithm.options, threads);
+  hasher.Hash(files, [&](const File& file, const std::optional<T>& crc) {
+    const uint64_t value = expected[index++];
+    if (!crc) {
+      printf("%s: FAILED open or read\n", file.path.c_str());
+      ++failed;
+    } else if (*crc != value) {
+      printf("%s: FAILED\n", file.path.c_str());
+      ++failed;
+    } else {
+      printf("%s: OK\n", file.path.c_str());
+    }
+  });
+  if (failed > 0) {
+    fprintf(stderr, "hashlib-sum: WARNING: %zu of %zu files did NOT match\n",
+            failed, files.size());
+    status = 1;
+  }
+  return status;
+}
+
+template <typename T>
+int Run(const Algorithm& algorithm, size_t threads, bool check,
+        const std::vector<std::string>& paths) {
+  return (check) ? Check<T>(algorithm, threads, paths)
+                 : Print<T>(algorithm, threads, paths);
+}
+
+int Usage(const char* program) {
+  fprintf(stderr,
+          "Usage: %s [-a ALGORITHM] [-j THREADS] [-c] [PATH]...\n"
+          "With no PATH, or when PATH is -, read standard input.\n"
+          "Algorithms:",
+          program);
+  for (const Algorithm& algorithm : kAlgorithms) {
+    fprintf(stderr, " %s", algorithm.name);
+  }
+  fprintf(stderr, " (default crc32)\n");
+  return 2;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const Algorithm* algorithm = &kAlgorithms[2];
+  size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+  bool check = false;
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; ++i) {
+    const std::string argument = argv[i];
+    if (argument == "-a" && i + 1 < argc) {
+      const std::string name = argv[++i];
+      algorithm = nullptr;
+      for (const Algorithm& candidate : kAlgorithms) {
+        if (name == candidate.name) {
+          algorithm = &candidate;
+        }
+      }
+      if (algorithm == nullptr) {
+        return Usage(argv[0]);
+      }
+    } else if (argument == "-j" && i + 1 < argc) {
+      threads = std::max<size_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+    } else if (argument == "-c") {
+      check = true;
+    } else if (argument != kStdin && !argument.empty() && argument[0] == '-') {
+      return Usage(argv[0]);
+    } else {
+      paths.push_back(argument);
+    }
+  }
+  if (paths.empty()) {
+    paths.push_back(kStdin);
+  }
+  switch (algorithm->bits) {
+    case 16:
+      return Run<uint16_t>(*algorithm, threads, check, paths);
+    case 32:
+      return Run<uint32_t>(*algorithm, threads, check, paths);
+    default:
+      return Run<uint64_t>(*algorithm, threads, check, paths);
+  }
+}
@@ -0,0 +1,122 @@
+#ifndef MULTI_CRC_H_
+#define MULTI_CRC_H_
+
+#include <algorithm>    // std::min
+#include <cstdint>      // uint8_t
+#include <tuple>        // std::tuple / std::apply
+#include <type_traits>  // std::tuple_element_t
+#include <utility>      // std::index_sequence
+
+#include "crc.h"
+
+namespace hash {
+
+// Bytes consumed by every CRC of MultiCrc before the next tile is loaded.
+// Small enough to stay in L1/L2 cache next to the lookup tables.
+constexpr size_t kMultiCrcTileSize = 16 * 1024;
+
+// Several CRC variants of the same data calculated in a single pass. Data is
+// split into tiles and every CRC consumes the tile while it is still cached,
+// so the data is streamed from memory only once. Each CRC keeps its own
+// processing method, e.g. CRC32 and CRC32C both use HW_CLMUL if available.
+template <typename... T>
+class MultiCrc {
+ public:
+  static_assert(sizeof...(T) > 0, "MultiCrc requires at least one CRC.");
+
+  // Value type of the I-th CRC.
+  template <size_t I>
+  using Type = std::tuple_element_t<I, std::tuple<T...>>;
+
+  MultiCrc() = delete;
+  // Start from the state of given CRCs, e.g. MultiCrc(NewCrc32(),
+  // Crc<uint32_t>(OptionsCrc::Crc32C())).
+  explicit MultiCrc(const Crc<T>&... crcs) : crcs_(crcs...) {}
+  ~MultiCrc() = default;
+
+  // Consume specified number of elements from given array of any type by
+  // every CRC.
+  template <typename Y>
+  void Consume(const Y* data, size_t size) noexcept;
+
+  // Retrieve CRC value of the I-th CRC.
+  template <size_t I>
+  Type<I> crc() const noexcept;
+  // Retrieve all CRC values.
+  std::tuple<T...> crc() const noexcept;
+  // Reset all CRC values to initial ones.
+  void reset() noexcept;
+
+  // Access I-th CRC, e.g. to Combine() its values.
+  template <size_t I>
+  const Crc<Type<I>>& get() const noexcept;
+  template <size_t I>
+  Crc<Type<I>>& get() noexcept;
+
+ private:
+  template <size_t... I>
+  void ConsumeTile(const uint8_t* data, size_t size,
+                   std::index_sequence<I...>) noexcept;
+
+  std::tuple<Crc<T>...> crcs_;
+};
+
+template <typename... T>
+MultiCrc(const Crc<T>&...) -> MultiCrc<T...>;
+
+template <typename... T>
+template <typename Y>
+void MultiCrc<T...>::Consume(const Y* data, size_t size) noexcept {
+  const auto* bytes = reinterpret_cast<const uint8_t*>(data);
+  size *= sizeof(Y);
+  while (size > 0) {
+    const size_t tile = std::min(size, kMultiCrcTileSize);
+    ConsumeTile(bytes, tile, std::index_sequence_for<T...>());
+    bytes += tile;
+    size -= tile;
+  }
+}
+
+template <typename... T>
+template <size_t... I>
+void MultiCrc<T...>::ConsumeTile(const uint8_t* data, size_t size,
+                                 std::index_sequence<I...>) noexcept {
+  (std::get<I>(crcs_).Consume(data, size), ...);
+}
+
+template <typename... T>
+template <size_t I>
+typename MultiCrc<T...>::template Type<I> MultiCrc<T...>::crc()
+    const noexcept {
+  return std::get<I>(crcs_).crc();
+}
+
+template <typename... T>
+std::tuple<T...> MultiCrc<T...>::crc() const noexcept {
+  return std::apply(
+      [](const Crc<T>&... crcs) { return std::tuple<T...>(crcs.crc()...); },
+      crcs_);
+}
+
+template <typename... T>
+void MultiCrc<T...>::reset() noexcept {
+  std::apply([](Crc<T>&... crcs) { (crcs.reset(), ...); }, crcs_);
+}
+
+template <typename... T>
+template <size_t I>
+const Crc<typename MultiCrc<T...>::template Type<I>>& MultiCrc<T...>::get()
+    const noexcept {
+  return std::get<I>(crcs_);
+}
+
+template <typename... T>
+template <size_t I>
+Crc<typename MultiCrc<T...>::template Type<I>>&
+MultiCrc<T...>::get() noexcept {
+  return std::get<I>(crcs_);
+}
+
+}  // namespace hash
+
+#endif  // MULTI_CRC_H_
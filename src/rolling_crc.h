@@ -0,0 +1,166 @@
+#ifndef ROLLING_CRC_H_
+#define ROLLING_CRC_H_
+
+#include <array>    // std::array
+#include <cstdint>  // uint8_t
+
+#include "crc.h"
+
+namespace hash {
+
+// CRC of a fixed size window sliding over the data one byte at a time, e.g.
+// for content defined chunking. Entering byte is consumed as usual, leaving
+// byte is removed with a table of its contribution after 'window' more bytes,
+// so every step costs two lookups regardless of the window size.
+template <typename T>
+class RollingCrc {
+ public:
+  RollingCrc() = delete;
+  RollingCrc(size_t window, const OptionsCrc& options = OptionsCrc::Crc32());
+  ~RollingCrc() = default;
+
+  // Consume byte while the window is not full yet.
+  void Push(uint8_t in) noexcept;
+  // Slide window by one byte. 'out' is the byte consumed 'window' bytes ago.
+  void Roll(uint8_t out, uint8_t in) noexcept;
+
+  // CRC of the last 'window' bytes. Valid once the window is full.
+  T crc() const noexcept;
+  // Start with an empty window.
+  void reset() noexcept;
+  size_t window() const noexcept;
+
+  // Scan windows starting at data[0] for the first one, whose CRC masked by
+  // 'mask' equals 'value'. Returns number of bytes up to the end of that
+  // window, or 'size' if there is none. Does not modify the state.
+  size_t FindBoundary(const uint8_t* data, size_t size, T mask,
+                      T value) const noexcept;
+
+ private:
+  template <bool reflected>
+  T Step(T crc, uint8_t in) const noexcept;
+  template <bool reflected>
+  size_t Scan(const uint8_t* data, size_t size, T mask,
+              T value) const noexcept;
+
+  T crc_;
+  // Contribution of the initial register, shifted over the whole window.
+  T initial_term_;
+  T xor_output_;
+  bool reverse_data_;
+  bool reverse_out_;
+  // Shift converting register sized CRC value to the value of given width.
+  uint8_t out_shift_;
+  size_t window_;
+  const CrcTable<T>* table_;
+  // Register of every byte value followed by 'window' zero bytes.
+  std::array<T, 256> out_;
+};
+
+template <typename T>
+RollingCrc<T>::RollingCrc(size_t window, const OptionsCrc& options)
+    : crc_(0),
+      reverse_data_(options.reverse_data),
+      reverse_out_(options.reverse_out),
+      out_shift_(detail::OutputShift<T>(options.width, options.reverse_out)),
+      window_(window) {
+  const T polynomial =
+      detail::AlignRegister<T>(options.polynomial, options.width);
+  xor_output_ =
+      static_cast<T>(static_cast<T>(options.xor_output) << out_shift_);
+  table_ = detail::GetCrcTable(polynomial, reverse_data_, 1);
+  const T shift = detail::XPowMod(polynomial, uint64_t{8} * window);
+  initial_term_ = detail::ShiftRegister(
+      detail::InitialRegister(
+          detail::AlignRegister<T>(options.initial_crc, options.width),
+          reverse_data_),
+      shift, polynomial, reverse_data_);
+  // Single byte consumed by an empty register is the table value itself.
+  for (size_t i = 0; i < out_.size(); ++i) {
+    out_[i] = detail::ShiftRegister(table_->lookup[0][i], shift, polynomial,
+                                    reverse_data_);
+  }
+}
+
+template <typename T>
+template <bool reflected>
+T RollingCrc<T>::Step(T crc, uint8_t in) const noexcept {
+  if constexpr (reflected) {
+    return (crc >> 8) ^ table_->lookup[0][(crc ^ in) & 0xFF];
+  } else {
+    static constexpr uint32_t shift = (sizeof(T) * 8) - 8;
+    return static_cast<T>(crc << 8) ^
+           table_->lookup[0][((crc >> shift) ^ in) & 0xFF];
+  }
+}
+
+template <typename T>
+void RollingCrc<T>::Push(uint8_t in) noexcept {
+  crc_ = (reverse_data_) ? Step<true>(crc_, in) : Step<false>(crc_, in);
+}
+
+template <typename T>
+void RollingCrc<T>::Roll(uint8_t out, uint8_t in) noexcept {
+  Push(in);
+  crc_ ^= out_[out];
+}
+
+template <typename T>
+T RollingCrc<T>::crc() const noexcept {
+  const T value = detail::FinalCrc(static_cast<T>(crc_ ^ initial_term_),
+                                   xor_output_, reverse_data_, reverse_out_);
+  return static_cast<T>(value >> out_shift_);
+}
+
+template <typename T>
+void RollingCrc<T>::reset() noexcept {
+  crc_ = 0;
+}
+
+template <typename T>
+size_t RollingCrc<T>::window() const noexcept {
+  return window_;
+}
+
+template <typename T>
+size_t RollingCrc<T>::FindBoundary(const uint8_t* data, size_t size, T mask,
+                                   T value) const noexcept {
+  if (size < window_) {
+    return size;
+  }
+  // Compare registers directly: move the output transformation to the
+  // mask and the expected value.
+  mask = static_cast<T>(mask << out_shift_);
+  value = static_cast<T>((value << out_shift_) ^ xor_output_) & mask;
+  if (reverse_data_ ^ reverse_out_) {
+    mask = detail::ReverseBits(mask);
+    value = detail::ReverseBits(value);
+  }
+  value ^= initial_term_ & mask;
+  return (reverse_data_) ? Scan<true>(data, size, mask, value)
+                         : Scan<false>(data, size, mask, value);
+}
+
+template <typename T>
+template <bool reflected>
+size_t RollingCrc<T>::Scan(const uint8_t* data, size_t size, T mask,
+                           T value) const noexcept {
+  T crc = 0;
+  for (size_t i = 0; i < window_; ++i) {
+    crc = Step<reflected>(crc, data[i]);
+  }
+  if ((crc & mask) == value) {
+    return window_;
+  }
+  for (size_t i = window_; i < size; ++i) {
+    crc = Step<reflected>(crc, data[i]) ^ out_[data[i - window_]];
+    if ((crc & mask) == value) {
+      return i + 1;
+    }
+  }
+  return size;
+}
+
+}  // namespace hash
+
+#endif  // ROLLING_CRC_H_
@@ -0,0 +1,245 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <algorithm>           // std::max
+#include <atomic>              // std::atomic
+#include <condition_variable>  // std::condition_variable
+#include <deque>               // std::deque
+#include <functional>          // std::function
+#include <future>              // std::future / std::packaged_task
+#include <memory>              // std::make_shared
+#include <mutex>               // std::mutex / std::unique_lock
+#include <thread>              // std::thread
+#include <type_traits>         // std::invoke_result_t
+#include <vector>              // std::vector
+
+namespace hash {
+
+// Fixed size pool of worker threads executing submitted tasks in FIFO order.
+// Satisfies requirements of Crc::ConsumeParallel().
+class ThreadPool {
+ public:
+  explicit ThreadPool(size_t threads = std::thread::hardware_concurrency());
+  ~ThreadPool();
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // Number of worker threads.
+  size_t size() const noexcept;
+
+  // Schedule 'task' for execution. Returned future holds its result.
+  template <typename F>
+  std::future<std::invoke_result_t<F>> Submit(F&& task);
+
+ private:
+  void Run();
+
+  std::vector<std::thread> workers_;
+  std::deque<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool stop_ = false;
+};
+
+// Pool of worker threads, each with its own task queue. Tasks submitted by a
+// worker go to its own queue and run newest first, idle workers steal the
+// oldest tasks of the others. Uneven tasks are balanced without contending on
+// a single queue. Satisfies requirements of Crc::ConsumeParallel().
+class WorkStealingPool {
+ public:
+  explicit WorkStealingPool(
+      size_t threads = std::thread::hardware_concurrency());
+  ~WorkStealingPool();
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  // Number of worker threads.
+  size_t size() const noexcept;
+
+  // Schedule 'task' for execution. Returned future holds its result.
+  template <typename F>
+  std::future<std::invoke_result_t<F>> Submit(F&& task);
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  void Run(size_t index);
+  void Push(std::function<void()> task);
+  // Take the newest task of worker 'index' or steal the oldest one of others.
+  bool Pop(size_t index, std::function<void()>* task);
+
+  // Worker running on the current thread, if any.
+  inline static thread_local const WorkStealingPool* current_pool_ = nullptr;
+  inline static thread_local size_t current_index_ = 0;
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> workers_;
+  // Number of tasks in all queues, incremented before a task is pushed.
+  std::atomic<size_t> pending_{0};
+  std::atomic<size_t> next_queue_{0};
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool stop_ = false;
+};
+
+inline ThreadPool::ThreadPool(size_t threads) {
+  threads = std::max<size_t>(threads, 1);
+  workers_.reserve(threads);
+  for (size_t i = 0; i < threads; ++i) {
+    workers_.emplace_back([this] { Run(); });
+  }
+}
+
+inline ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  condition_.notify_all();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+inline size_t ThreadPool::size() const noexcept { return workers_.size(); }
+
+template <typename F>
+std::future<std::invoke_result_t<F>> ThreadPool::Submit(F&& task) {
+  using Result = std::invoke_result_t<F>;
+  // std::function requires copyable callable, packaged_task is move only.
+  auto packaged =
+      std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+  std::future<Result> result = packaged->get_future();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.emplace_back([packaged] { (*packaged)(); });
+  }
+  condition_.notify_one();
+  return result;
+}
+
+inline void ThreadPool::Run() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+      // Finish remaining tasks before stopping.
+      if (tasks_.empty()) {
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+inline WorkStealingPool::WorkStealingPool(size_t threads) {
+  threads = std::max<size_t>(threads, 1);
+  queues_.reserve(threads);
+  for (size_t i = 0; i < threads; ++i) {
+    queues_.push_back(std::make_unique<Queue>());
+  }
+  workers_.reserve(threads);
+  for (size_t i = 0; i < threads; ++i) {
+    workers_.emplace_back([this, i] { Run(i); });
+  }
+}
+
+inline WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  condition_.notify_all();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+inline size_t WorkStealingPool::size() const noexcept {
+  return workers_.size();
+}
+
+template <typename F>
+std::future<std::invoke_result_t<F>> WorkStealingPool::Submit(F&& task) {
+  using Result = std::invoke_result_t<F>;
+  // std::function requires copyable callable, packaged_task is move only.
+  auto packaged =
+      std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+  std::future<Result> result = packaged->get_future();
+  Push([packaged] { (*packaged)(); });
+  return result;
+}
+
+inline void WorkStealingPool::Push(std::function<void()> task) {
+  // Other threads distribute tasks round robin.
+  const size_t index =
+      (current_pool_ == this)
+          ? current_index_
+          : next_queue_.fetch_add(1, std::memory_order_relaxed) %
+                queues_.size();
+  {
+    // Increment under the lock, so a worker can not miss the notification,
+    // and before the task is published, so Pop() of a stealing worker can
+    // not decrement first and wrap the count around.
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.fetch_add(1, std::memory_order_relaxed);
+  }
+  try {
+    std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+    queues_[index]->tasks.push_back(std::move(task));
+  } catch (...) {
+    pending_.fetch_sub(1, std::memory_order_relaxed);
+    throw;
+  }
+  condition_.notify_one();
+}
+
+inline bool WorkStealingPool::Pop(size_t index, std::function<void()>* task) {
+  for (size_t i = 0; i < queues_.size(); ++i) {
+    Queue& queue = *queues_[(index + i) % queues_.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+      continue;
+    }
+    if (i == 0) {
+      *task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    } else {
+      *task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+    pending_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+  return false;
+}
+
+inline void WorkStealingPool::Run(size_t index) {
+  current_pool_ = this;
+  current_index_ = index;
+  while (true) {
+    std::function<void()> task;
+    if (Pop(index, &task)) {
+      task();
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this] {
+      return stop_ || pending_.load(std::memory_order_relaxed) > 0;
+    });
+    // Finish remaining tasks before stopping.
+    if (stop_ && pending_.load(std::memory_order_relaxed) == 0) {
+      return;
+    }
+  }
+}
+
+}  // namespace hash
+
+#endif  // THREAD_POOL_H_